@@ -35,6 +35,7 @@ macro(assemble_executable_target TARGET_NAME)
         list(APPEND _private_${TARGET_NAME}_COMPILE_OPTIONS -g3)
     elseif(_private_${TARGET_NAME}_BUILD_TYPE STREQUAL RELEASE)
         list(APPEND _private_${TARGET_NAME}_COMPILE_OPTIONS -O2)
+        list(APPEND _private_${TARGET_NAME}_DEFINITIONS NDEBUG)
     endif(_private_${TARGET_NAME}_BUILD_TYPE STREQUAL DEBUG)
 
     add_executable(${TARGET_NAME} ${_private_${TARGET_NAME}_HEADERS} ${_private_${TARGET_NAME}_SOURCES})
@@ -50,6 +51,7 @@ macro(assemble_library_target TARGET_NAME LIBTYPE)
         list(APPEND _private_${TARGET_NAME}_COMPILE_OPTIONS -g3)
     elseif(_private_${TARGET_NAME}_BUILD_TYPE STREQUAL RELEASE)
         list(APPEND _private_${TARGET_NAME}_COMPILE_OPTIONS -O2)
+        list(APPEND _private_${TARGET_NAME}_DEFINITIONS NDEBUG)
     endif(_private_${TARGET_NAME}_BUILD_TYPE STREQUAL DEBUG)
 
     add_library(${TARGET_NAME} ${LIBTYPE} ${_private_${TARGET_NAME}_HEADERS} ${_private_${TARGET_NAME}_SOURCES})
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+
+// Times the vector expressions of the clipper and the normal computation
+// against the same arithmetic written out by hand on plain doubles. With
+// the expression layer both columns should match, and so should the results.
+
+namespace
+{
+    const size_t count = 1 << 16;
+    const int rounds = 200;
+
+    double now_ms()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    double random_unit()
+    {
+        return std::rand()/static_cast<double>(RAND_MAX)*2.0 - 1.0;
+    }
+
+    // best of rounds, the least disturbed run
+    template<class body_t>
+    double time_ms(body_t body)
+    {
+        double best = 0.0;
+        for (int r = 0; r < rounds; ++r)
+        {
+            const double start = now_ms();
+            body();
+            const double elapsed = now_ms() - start;
+            best = r == 0 ? elapsed : std::min(best, elapsed);
+        }
+        return best;
+    }
+
+    // returns same, so main can fail when the results differ
+    bool report(const char* name, double expression_ms, double scalar_ms, bool same)
+    {
+        std::cout << name << ": expression " << expression_ms << " ms, scalar " << scalar_ms
+                  << " ms, ratio " << expression_ms/scalar_ms << (same ? "" : ", RESULTS DIFFER") << std::endl;
+        return same;
+    }
+}
+
+int main()
+{
+    std::vector<point4d> a(count), b(count);
+    std::vector<point3d> p0(count), p1(count), p2(count);
+    std::vector<double> t(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        a[i] = point4d({random_unit(), random_unit(), random_unit(), 1.0});
+        b[i] = point4d({random_unit(), random_unit(), random_unit(), 1.0});
+        p0[i] = point3d(random_unit(), random_unit(), random_unit());
+        p1[i] = point3d(random_unit(), random_unit(), random_unit());
+        p2[i] = point3d(random_unit(), random_unit(), random_unit());
+        t[i] = 0.5 + random_unit()/2.0;
+    }
+
+    bool same = true;
+
+    // clip edge interpolation, a + (b - a)*t
+    std::vector<point4d> lerp_expression(count);
+    std::vector<point4d> lerp_scalar(count);
+    const double lerp_expression_ms = time_ms([&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            lerp_expression[i] = a[i] + (b[i] - a[i])*t[i];
+        }
+    });
+    const double lerp_scalar_ms = time_ms([&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                lerp_scalar[i][c] = a[i][c] + (b[i][c] - a[i][c])*t[i];
+            }
+        }
+    });
+    same = report("lerp", lerp_expression_ms, lerp_scalar_ms, lerp_expression == lerp_scalar) && same;
+
+    // face normal, (p1 - p0) x (p2 - p0)
+    std::vector<point3d> normal_expression(count);
+    std::vector<point3d> normal_scalar(count);
+    const double normal_expression_ms = time_ms([&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            normal_expression[i] = (p1[i] - p0[i]).vec_prod(p2[i] - p0[i]);
+        }
+    });
+    const double normal_scalar_ms = time_ms([&]()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double ux = p1[i].x() - p0[i].x(), uy = p1[i].y() - p0[i].y(), uz = p1[i].z() - p0[i].z();
+            const double vx = p2[i].x() - p0[i].x(), vy = p2[i].y() - p0[i].y(), vz = p2[i].z() - p0[i].z();
+            normal_scalar[i] = point3d(uy*vz - uz*vy, uz*vx - ux*vz, ux*vy - uy*vx);
+        }
+    });
+    same = report("normal", normal_expression_ms, normal_scalar_ms, normal_expression == normal_scalar) && same;
+
+    // dot of a difference, (p1 - p0)*p2
+    double dot_expression = 0.0, dot_scalar = 0.0;
+    const double dot_expression_ms = time_ms([&]()
+    {
+        dot_expression = 0.0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            dot_expression += (p1[i] - p0[i])*p2[i];
+        }
+    });
+    const double dot_scalar_ms = time_ms([&]()
+    {
+        dot_scalar = 0.0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            dot_scalar += (p1[i].x() - p0[i].x())*p2[i].x() + (p1[i].y() - p0[i].y())*p2[i].y() + (p1[i].z() - p0[i].z())*p2[i].z();
+        }
+    });
+    same = report("dot", dot_expression_ms, dot_scalar_ms, dot_expression == dot_scalar) && same;
+    return same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,160 @@
+#include "file_mapping.hpp"
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool file_stamp::read(const std::string& path, file_stamp& stamp)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+    {
+        return false;
+    }
+    stamp.size = static_cast<uint64_t>(info.st_size);
+    stamp.mtime = static_cast<int64_t>(info.st_mtime);
+    return true;
+}
+
+#ifdef _WIN32
+
+file_mapping::file_mapping() :
+    _data(nullptr)
+  , _size(0)
+  , _open(false)
+  , _file(INVALID_HANDLE_VALUE)
+  , _mapping(nullptr)
+{}
+
+bool file_mapping::open(const std::string& path)
+{
+    close();
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size))
+    {
+        close();
+        return false;
+    }
+    _size = static_cast<size_t>(size.QuadPart);
+    if (_size != 0)
+    {
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping == nullptr)
+        {
+            close();
+            return false;
+        }
+        _data = static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (_data == nullptr)
+        {
+            close();
+            return false;
+        }
+    }
+    _open = true;
+    return true;
+}
+
+void file_mapping::close()
+{
+    if (_data != nullptr)
+    {
+        UnmapViewOfFile(_data);
+    }
+    if (_mapping != nullptr)
+    {
+        CloseHandle(_mapping);
+    }
+    if (_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_file);
+    }
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+    _file = INVALID_HANDLE_VALUE;
+    _mapping = nullptr;
+}
+
+#else
+
+file_mapping::file_mapping() :
+    _data(nullptr)
+  , _size(0)
+  , _open(false)
+{}
+
+bool file_mapping::open(const std::string& path)
+{
+    close();
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0)
+    {
+        ::close(file);
+        return false;
+    }
+    _size = static_cast<size_t>(info.st_size);
+    if (_size != 0)
+    {
+        void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(file);
+            _size = 0;
+            return false;
+        }
+        _data = static_cast<const char*>(data);
+    }
+    ::close(file); // the mapping stays valid
+    _open = true;
+    return true;
+}
+
+void file_mapping::close()
+{
+    if (_data != nullptr)
+    {
+        munmap(const_cast<char*>(_data), _size);
+    }
+    _data = nullptr;
+    _size = 0;
+    _open = false;
+}
+
+#endif
+
+file_mapping::~file_mapping()
+{
+    close();
+}
+
+bool file_mapping::is_open() const
+{
+    return _open;
+}
+
+const char* file_mapping::data() const
+{
+    return _data;
+}
+
+size_t file_mapping::size() const
+{
+    return _size;
+}
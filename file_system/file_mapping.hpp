@@ -0,0 +1,58 @@
+#ifndef FILE_MAPPING_HPP
+#define FILE_MAPPING_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Size and modification time of a file, used to tell when a derived file
+// went stale.
+class file_stamp
+{
+public:
+    file_stamp() :
+        size(0)
+      , mtime(0)
+    {}
+
+    static bool read(const std::string& path, file_stamp& stamp);
+
+    uint64_t size;
+    int64_t mtime;
+};
+
+// Read only mapping of a whole file, the pages are loaded on first touch and
+// shared with the OS file cache.
+class file_mapping
+{
+public:
+    file_mapping();
+
+    ~file_mapping();
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    // false when the file can't be opened or mapped
+    bool open(const std::string& path);
+
+    void close();
+
+    bool is_open() const;
+
+    // nullptr for an empty file
+    const char* data() const;
+
+    size_t size() const;
+
+private:
+    const char* _data;
+    size_t _size;
+    bool _open;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#endif
+};
+
+#endif // FILE_MAPPING_HPP
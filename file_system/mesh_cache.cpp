@@ -0,0 +1,292 @@
+#include "mesh_cache.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include "model/face_order.hpp"
+
+namespace
+{
+    static_assert(sizeof(point3d) == 3*sizeof(double), "point3d is stored as three packed doubles");
+    static_assert(std::is_standard_layout<point3d>::value, "cached arrays are mapped in place");
+
+    const char magic[8] = {'H', 'R', 'M', 'E', 'S', 'H', '\r', '\n'};
+    const uint32_t byte_order = 0x01020304;
+
+    enum section_id
+    {
+        section_vertexes
+        ,section_texture_vertexes
+        ,section_normals
+        ,section_coord_indexes
+        ,section_texture_indexes
+        ,section_normal_indexes
+        ,sections_count
+    };
+
+    class section
+    {
+    public:
+        uint64_t offset;
+        uint64_t count;
+        uint64_t element_size;
+    };
+
+    class header
+    {
+    public:
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t source_size;
+        int64_t source_mtime;
+        uint64_t source_hash;
+        section sections[sections_count];
+    };
+
+    size_t align(size_t offset)
+    {
+        return (offset + mesh_cache::section_alignment - 1)/mesh_cache::section_alignment*mesh_cache::section_alignment;
+    }
+
+    bool valid_section(const section& s, size_t file_size)
+    {
+        return s.element_size != 0
+            && s.offset%mesh_cache::section_alignment == 0
+            && s.offset <= file_size
+            && s.count <= (file_size - s.offset)/s.element_size;
+    }
+
+    template<class value_t>
+    bool valid_section(const section& s, size_t file_size)
+    {
+        return s.element_size == sizeof(value_t) && valid_section(s, file_size);
+    }
+
+    bool valid_index_section(const section& s, size_t file_size)
+    {
+        return (s.element_size == sizeof(uint16_t) || s.element_size == sizeof(uint32_t)) && valid_section(s, file_size);
+    }
+
+    template<class value_t>
+    void borrow(model_array<value_t>& array, const section& s, const std::shared_ptr<file_mapping>& mapping)
+    {
+        array.borrow(reinterpret_cast<const value_t*>(mapping->data() + s.offset), static_cast<size_t>(s.count), mapping);
+    }
+
+    void borrow(index_buffer& indexes, const section& s, const std::shared_ptr<file_mapping>& mapping)
+    {
+        indexes.borrow(mapping->data() + s.offset, static_cast<size_t>(s.count), static_cast<size_t>(s.element_size), mapping);
+    }
+
+    section place(size_t count, size_t element_size, size_t& offset)
+    {
+        section s;
+        s.offset = align(offset);
+        s.count = count;
+        s.element_size = element_size;
+        offset = s.offset + count*element_size;
+        return s;
+    }
+
+    template<class value_t>
+    section place(const model_array<value_t>& array, size_t& offset)
+    {
+        return place(array.size(), sizeof(value_t), offset);
+    }
+
+    section place(const index_buffer& indexes, size_t& offset)
+    {
+        return place(indexes.size(), indexes.element_size(), offset);
+    }
+
+    void write_section(std::ofstream& output, const void* data, const section& s)
+    {
+        const std::streamoff position = output.tellp();
+        const std::string padding(static_cast<size_t>(s.offset - position), '\0');
+        output.write(padding.data(), padding.size());
+        output.write(static_cast<const char*>(data), s.count*s.element_size);
+    }
+
+    model load_with(const std::string& obj_path, const std::function<model(const char*, const char*)>& parse
+                    , mesh_cache::load_stats* stats)
+    {
+        mesh_cache::load_stats result;
+        file_stamp source;
+        if (!file_stamp::read(obj_path, source))
+        {
+            throw std::runtime_error("can't open wavefront.obj file");
+        }
+        const std::string cache_path = mesh_cache::cache_path(obj_path);
+        model m;
+        if (mesh_cache::read(cache_path, obj_path, source, m))
+        {
+            if (stats)
+            {
+                *stats = result;
+            }
+            return m;
+        }
+        file_mapping obj;
+        if (!obj.open(obj_path))
+        {
+            throw std::runtime_error("can't open wavefront.obj file");
+        }
+        m = parse(obj.data(), obj.data() + obj.size());
+        m.weld();
+        result.rebuilt = true;
+        result.acmr_before = face_order::acmr(m);
+        face_order::optimize(m);
+        result.acmr_after = face_order::acmr(m);
+        mesh_cache::write(cache_path, source, mesh_cache::hash(obj.data(), obj.size()), m); // a read only directory only costs the next start
+        if (stats)
+        {
+            *stats = result;
+        }
+        return m;
+    }
+}
+
+model mesh_cache::load(const std::string& obj_path, load_stats* stats)
+{
+    return load_with(obj_path, [](const char* begin, const char* end)
+    {
+        return wavefront_obj::parse(begin, end);
+    }, stats);
+}
+
+model mesh_cache::load(const std::string& obj_path, parallel::thread_pool& pool, load_stats* stats)
+{
+    return load_with(obj_path, [&pool](const char* begin, const char* end)
+    {
+        return wavefront_obj::parse(begin, end, pool);
+    }, stats);
+}
+
+model mesh_cache::load(const std::string& obj_path, size_t block_bytes, const wavefront_obj::progress_type& progress, load_stats* stats)
+{
+    return load_with(obj_path, [block_bytes, &progress](const char* begin, const char* end)
+    {
+        return wavefront_obj::parse(begin, end, block_bytes, progress);
+    }, stats);
+}
+
+std::string mesh_cache::cache_path(const std::string& obj_path)
+{
+    return obj_path + ".cache";
+}
+
+bool mesh_cache::read(const std::string& cache_path, const std::string& obj_path, const file_stamp& source, model& m)
+{
+    std::shared_ptr<file_mapping> mapping = std::make_shared<file_mapping>();
+    if (!mapping->open(cache_path) || mapping->size() < sizeof(header))
+    {
+        return false;
+    }
+    header head;
+    std::memcpy(&head, mapping->data(), sizeof(head));
+    if (std::memcmp(head.magic, magic, sizeof(magic)) != 0 || head.version != version || head.byte_order != byte_order
+        || !valid_section<point3d>(head.sections[section_vertexes], mapping->size())
+        || !valid_section<point3d>(head.sections[section_texture_vertexes], mapping->size())
+        || !valid_section<point3d>(head.sections[section_normals], mapping->size())
+        || !valid_index_section(head.sections[section_coord_indexes], mapping->size())
+        || !valid_index_section(head.sections[section_texture_indexes], mapping->size())
+        || !valid_index_section(head.sections[section_normal_indexes], mapping->size()))
+    {
+        return false;
+    }
+    if (head.source_size != source.size)
+    {
+        return false;
+    }
+    if (head.source_mtime != source.mtime)
+    {
+        file_mapping obj;
+        if (!obj.open(obj_path) || hash(obj.data(), obj.size()) != head.source_hash)
+        {
+            return false;
+        }
+    }
+
+    borrow(m.vertexes, head.sections[section_vertexes], mapping);
+    borrow(m.texture_vertexes, head.sections[section_texture_vertexes], mapping);
+    borrow(m.normals, head.sections[section_normals], mapping);
+    borrow(m.coord_indexes, head.sections[section_coord_indexes], mapping);
+    borrow(m.texture_indexes, head.sections[section_texture_indexes], mapping);
+    borrow(m.normal_indexes, head.sections[section_normal_indexes], mapping);
+    m.drop_invalid_faces(); // only copies the indexes of a damaged cache
+    m.update_normals(); // derived, the cache doesn't store them
+    return true;
+}
+
+bool mesh_cache::write(const std::string& cache_path, const file_stamp& source, uint64_t source_hash, const model& m)
+{
+    header head;
+    std::memset(&head, 0, sizeof(head));
+    std::memcpy(head.magic, magic, sizeof(magic));
+    head.version = version;
+    head.byte_order = byte_order;
+    head.source_size = source.size;
+    head.source_mtime = source.mtime;
+    head.source_hash = source_hash;
+    size_t offset = sizeof(head);
+    head.sections[section_vertexes] = place(m.vertexes, offset);
+    head.sections[section_texture_vertexes] = place(m.texture_vertexes, offset);
+    head.sections[section_normals] = place(m.normals, offset);
+    head.sections[section_coord_indexes] = place(m.coord_indexes, offset);
+    head.sections[section_texture_indexes] = place(m.texture_indexes, offset);
+    head.sections[section_normal_indexes] = place(m.normal_indexes, offset);
+
+    const std::string temporary = cache_path + ".tmp";
+    {
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        if (!output.good())
+        {
+            return false;
+        }
+        output.write(reinterpret_cast<const char*>(&head), sizeof(head));
+        write_section(output, m.vertexes.data(), head.sections[section_vertexes]);
+        write_section(output, m.texture_vertexes.data(), head.sections[section_texture_vertexes]);
+        write_section(output, m.normals.data(), head.sections[section_normals]);
+        write_section(output, m.coord_indexes.data(), head.sections[section_coord_indexes]);
+        write_section(output, m.texture_indexes.data(), head.sections[section_texture_indexes]);
+        write_section(output, m.normal_indexes.data(), head.sections[section_normal_indexes]);
+        if (!output.good())
+        {
+            output.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    std::remove(cache_path.c_str()); // rename doesn't replace on windows
+    if (std::rename(temporary.c_str(), cache_path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// FNV-1a over 8 byte words, then the tail bytes and the length.
+uint64_t mesh_cache::hash(const char* data, size_t size)
+{
+    const uint64_t prime = 1099511628211ull;
+    uint64_t value = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        value = (value ^ word)*prime;
+    }
+    for (; i < size; ++i)
+    {
+        value = (value ^ static_cast<unsigned char>(data[i]))*prime;
+    }
+    return (value ^ size)*prime;
+}
@@ -0,0 +1,68 @@
+#ifndef MESH_CACHE_HPP
+#define MESH_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "model/model.hpp"
+#include "parallel/thread_pool.hpp"
+
+#include "file_mapping.hpp"
+#include "wavefront_obj.hpp"
+
+// Binary copy of a parsed OBJ kept next to it as <obj>.cache: a header with
+// the format version and the size, mtime and content hash of the source,
+// then the model arrays and index buffers in their in memory layout, each
+// section aligned to section_alignment. Loading maps the file and the model
+// borrows the arrays straight from the mapping. The cache is native endian
+// and is rebuilt whenever it doesn't match this build or its source.
+class mesh_cache
+{
+public:
+    static const uint32_t version = 4;
+    static const size_t section_alignment = 64;
+
+    // What a load did. The average cache miss ratios, see face_order::acmr,
+    // are those of the parsed faces and of the reordered ones, and are only
+    // set when the cache was rebuilt.
+    class load_stats
+    {
+    public:
+        load_stats() :
+            rebuilt(false)
+          , acmr_before(0.0)
+          , acmr_after(0.0)
+        {}
+
+        bool rebuilt;
+        double acmr_before;
+        double acmr_after;
+    };
+
+    mesh_cache() {}
+
+    // Loads obj_path through its cache, parsing, welding and reordering the
+    // OBJ faces and writing the cache when it is missing or stale. stats,
+    // when given, receives what the load did.
+    static model load(const std::string& obj_path, load_stats* stats = nullptr);
+    static model load(const std::string& obj_path, parallel::thread_pool& pool, load_stats* stats = nullptr);
+
+    // Parses block by block when the cache is missing, see wavefront_obj::parse.
+    static model load(const std::string& obj_path, size_t block_bytes, const wavefront_obj::progress_type& progress
+                      , load_stats* stats = nullptr);
+
+    static std::string cache_path(const std::string& obj_path);
+
+    // False when the cache is missing, damaged, from another version or
+    // doesn't describe the source. The content hash is only checked, by
+    // reading the source, when the sizes match but the mtimes don't.
+    static bool read(const std::string& cache_path, const std::string& obj_path, const file_stamp& source, model& m);
+
+    // Writes to a temporary file and renames it over cache_path.
+    static bool write(const std::string& cache_path, const file_stamp& source, uint64_t source_hash, const model& m);
+
+    static uint64_t hash(const char* data, size_t size);
+};
+
+#endif // MESH_CACHE_HPP
@@ -0,0 +1,57 @@
+#include "model_loader.hpp"
+
+#include <chrono>
+
+#include "mesh_cache.hpp"
+
+model_loader::model_loader(const std::string& obj_path) :
+    _published_faces(0)
+{
+    _result = std::async(std::launch::async, &model_loader::load, this, obj_path).share();
+}
+
+model_loader::~model_loader()
+{
+    _result.wait();
+}
+
+std::shared_ptr<const model> model_loader::current() const
+{
+    return std::atomic_load(&_current);
+}
+
+bool model_loader::ready() const
+{
+    return _result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+std::shared_ptr<const model> model_loader::get() const
+{
+    return _result.get();
+}
+
+std::shared_ptr<const model> model_loader::load(const std::string& obj_path)
+{
+    std::shared_ptr<const model> complete = std::make_shared<model>(mesh_cache::load(obj_path, block_bytes, [this](const model& part)
+    {
+        progress(part);
+    }));
+    std::atomic_store(&_current, complete);
+    return complete;
+}
+
+// Publishes a copy whenever the face count has doubled, so all the copies
+// together cost about as much as one of the complete model.
+void model_loader::progress(const model& part)
+{
+    if (part.faces_count() < 2*_published_faces || part.faces_count() == 0)
+    {
+        return;
+    }
+    std::shared_ptr<model> snapshot = std::make_shared<model>(part);
+    snapshot->drop_invalid_faces(); // faces whose vertexes are in blocks not read yet
+    snapshot->compact();
+    snapshot->update_normals();
+    _published_faces = snapshot->faces_count();
+    std::atomic_store(&_current, std::shared_ptr<const model>(std::move(snapshot)));
+}
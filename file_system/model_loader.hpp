@@ -0,0 +1,48 @@
+#ifndef MODEL_LOADER_HPP
+#define MODEL_LOADER_HPP
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <string>
+
+#include "model/model.hpp"
+
+// Loads a model through the mesh cache on a thread of its own. current() is
+// what there is to draw: nothing at first, then, when the OBJ has to be
+// parsed, partial models of the faces read so far, then the complete model.
+// Each one is swapped in atomically and never changes afterwards, so the
+// render loop can hold on to it for a frame while the next one is built.
+class model_loader
+{
+public:
+    // bytes of OBJ parsed between two looks at the partial model
+    static const size_t block_bytes = 4 << 20;
+
+    explicit model_loader(const std::string& obj_path);
+
+    // Waits for the loading thread.
+    ~model_loader();
+
+    model_loader(const model_loader&) = delete;
+    model_loader& operator=(const model_loader&) = delete;
+
+    // Latest published model, nullptr until the first one.
+    std::shared_ptr<const model> current() const;
+
+    // True once loading has ended, get() doesn't block then.
+    bool ready() const;
+
+    // Waits for the complete model, rethrows what loading threw.
+    std::shared_ptr<const model> get() const;
+
+private:
+    std::shared_ptr<const model> load(const std::string& obj_path);
+    void progress(const model& part);
+
+    std::shared_ptr<const model> _current;
+    size_t _published_faces;
+    std::shared_future<std::shared_ptr<const model>> _result;
+};
+
+#endif // MODEL_LOADER_HPP
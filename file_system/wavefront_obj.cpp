@@ -1,9 +1,15 @@
 #include "wavefront_obj.hpp"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <stdexcept>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <utility>
+#include <vector>
 
 model wavefront_obj::read_model(std::istream& input)
 {
@@ -26,13 +32,16 @@ model wavefront_obj::read_model(std::istream& input)
             new_model.normals.push_back(read_normal(line));
             break;
         case line_type::face:
-            new_model.faces.push_back(read_face(line));
+            new_model.add_face(read_face(line));
             break;
         default:
             // throw std::runtime_error("wavefront.obj unexpected line type"); // ignore vp lines
             break;
         }
     }
+    new_model.drop_invalid_faces();
+    new_model.compact();
+    new_model.update_normals();
     return new_model;
 }
 
@@ -92,8 +101,415 @@ model::face_t wavefront_obj::read_face(const std::string& input)
     model::face_t tmp;
     for(int i = 0; i < 3; ++i)
     {
-        iss >> tmp.coords[i] >> divider >> tmp.texture[i] >> divider >> tmp.normals[i];
-        --tmp.coords[i]; --tmp.texture[i]; --tmp.normals[i];
+        long coord = 0, texture = 0, normal = 0;
+        iss >> coord >> divider >> texture >> divider >> normal;
+        tmp.coords[i] = static_cast<uint32_t>(coord - 1);
+        tmp.texture[i] = static_cast<uint32_t>(texture - 1);
+        tmp.normals[i] = static_cast<uint32_t>(normal - 1);
     }
     return tmp;
 }
+
+namespace
+{
+    inline bool is_blank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline bool is_digit(char c)
+    {
+        return static_cast<unsigned>(c - '0') < 10;
+    }
+
+    inline const char* skip_blanks(const char* p, const char* end)
+    {
+        while (p != end && is_blank(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char* next_line(const char* p, const char* end)
+    {
+        while (p != end && *p != '\n')
+        {
+            ++p;
+        }
+        return p == end ? end : p + 1;
+    }
+
+    // Up to 19 significant digits fit a uint64_t mantissa. When it is below
+    // 2^53 and the power of ten is at most 22, both are exact doubles and one
+    // multiplication or division rounds correctly, which covers the usual
+    // "0.532" style values. Anything else goes through strtod, so the result
+    // always matches the stream extraction of read_model. Missing numbers
+    // read as 0 like a failed extraction.
+    double parse_double(const char*& p, const char* end)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11
+                                        , 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        const char* start = p = skip_blanks(p, end);
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        bool exact = true;
+        bool any = false;
+        for (; p != end && is_digit(*p); ++p, any = true)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa*10 + (*p - '0');
+                digits += mantissa != 0;
+            }
+            else
+            {
+                ++exponent;
+                exact = exact && *p == '0';
+            }
+        }
+        if (p != end && *p == '.')
+        {
+            for (++p; p != end && is_digit(*p); ++p, any = true)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa*10 + (*p - '0');
+                    digits += mantissa != 0;
+                    --exponent;
+                }
+                else
+                {
+                    exact = exact && *p == '0';
+                }
+            }
+        }
+        if (!any)
+        {
+            p = start;
+            return 0.0;
+        }
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            const char* mark = p++;
+            bool negative_exponent = false;
+            if (p != end && (*p == '-' || *p == '+'))
+            {
+                negative_exponent = *p == '-';
+                ++p;
+            }
+            if (p == end || !is_digit(*p))
+            {
+                p = mark;
+            }
+            else
+            {
+                int value = 0;
+                for (; p != end && is_digit(*p); ++p)
+                {
+                    value = std::min(value*10 + (*p - '0'), 100000);
+                }
+                exponent += negative_exponent ? -value : value;
+            }
+        }
+
+        if (exact && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+        {
+            const double value = exponent < 0 ? mantissa/powers[-exponent] : mantissa*powers[exponent];
+            return negative ? -value : value;
+        }
+        const std::string token(start, p);
+        return std::strtod(token.c_str(), nullptr);
+    }
+
+    long parse_index(const char*& p, const char* end)
+    {
+        p = skip_blanks(p, end);
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+        long value = 0;
+        for (; p != end && is_digit(*p); ++p)
+        {
+            value = value*10 + (*p - '0');
+        }
+        return negative ? -value : value;
+    }
+
+    cmn::vec3f parse_vector(const char*& p, const char* end)
+    {
+        cmn::vec3f tmp(cmn::uninitialized);
+        tmp.x() = parse_double(p, end);
+        tmp.y() = parse_double(p, end);
+        tmp.z() = parse_double(p, end);
+        return tmp;
+    }
+
+    // Corner indexes of a face that were relative in the file. They are
+    // resolved against the arrays of the chunk the face was parsed in, so
+    // they need the offset of that chunk once the chunks are merged.
+    // Bit 3*corner + 0/1/2 marks the coords/texture/normals index.
+    class relative_fixup
+    {
+    public:
+        size_t face;
+        unsigned fields;
+    };
+
+    class chunk
+    {
+    public:
+        model part;
+        std::vector<relative_fixup> fixups;
+    };
+
+    // Positive indexes are 1 based, negative ones count back from the last
+    // element read so far, a missing index ends up as no_index.
+    inline uint32_t resolve_index(long index, size_t count, unsigned field, unsigned& relative)
+    {
+        if (index < 0)
+        {
+            relative |= 1u << field;
+            return static_cast<uint32_t>(static_cast<long>(count) + index);
+        }
+        return static_cast<uint32_t>(index - 1);
+    }
+
+    // v, v/vt, v//vn or v/vt/vn for the first three corners.
+    model::face_t parse_face(const char*& p, const char* end, chunk& out)
+    {
+        model::face_t tmp;
+        unsigned relative = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            long coord = parse_index(p, end), texture = 0, normal = 0;
+            if (p != end && *p == '/')
+            {
+                ++p;
+                if (p != end && *p != '/')
+                {
+                    texture = parse_index(p, end);
+                }
+                if (p != end && *p == '/')
+                {
+                    ++p;
+                    normal = parse_index(p, end);
+                }
+            }
+            tmp.coords[i] = resolve_index(coord, out.part.vertexes.size(), 3*i, relative);
+            tmp.texture[i] = resolve_index(texture, out.part.texture_vertexes.size(), 3*i + 1, relative);
+            tmp.normals[i] = resolve_index(normal, out.part.normals.size(), 3*i + 2, relative);
+        }
+        if (relative != 0)
+        {
+            out.fixups.push_back(relative_fixup{out.part.faces_count(), relative});
+        }
+        return tmp;
+    }
+
+    wavefront_obj::line_type parse_caption(const char*& p, const char* end)
+    {
+        p = skip_blanks(p, end);
+        const char* caption = p;
+        while (p != end && !is_blank(*p) && *p != '\n')
+        {
+            ++p;
+        }
+        const size_t length = p - caption;
+        if (length == 1 && caption[0] == 'v')
+        {
+            return wavefront_obj::line_type::vertex;
+        }
+        if (length == 1 && caption[0] == 'f')
+        {
+            return wavefront_obj::line_type::face;
+        }
+        if (length == 2 && caption[0] == 'v' && caption[1] == 't')
+        {
+            return wavefront_obj::line_type::texture;
+        }
+        if (length == 2 && caption[0] == 'v' && caption[1] == 'n')
+        {
+            return wavefront_obj::line_type::normal;
+        }
+        return wavefront_obj::line_type::none;
+    }
+
+    void parse_chunk(const char* begin, const char* end, chunk& out)
+    {
+        model& part = out.part;
+        for (const char* p = begin; p != end; p = next_line(p, end))
+        {
+            switch (parse_caption(p, end)) {
+            case wavefront_obj::line_type::vertex:
+                part.vertexes.push_back(parse_vector(p, end));
+                break;
+            case wavefront_obj::line_type::texture:
+                part.texture_vertexes.push_back(parse_vector(p, end));
+                break;
+            case wavefront_obj::line_type::normal:
+                part.normals.push_back(parse_vector(p, end));
+                break;
+            case wavefront_obj::line_type::face:
+                part.add_face(parse_face(p, end, out));
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    std::vector<char> read_whole_file(const std::string& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input.good())
+        {
+            throw std::runtime_error("can't open wavefront.obj file");
+        }
+        input.seekg(0, std::ios::end);
+        const std::streamoff size = input.tellg();
+        input.seekg(0, std::ios::beg);
+        std::vector<char> buffer(static_cast<size_t>(std::max<std::streamoff>(size, 0)));
+        if (!input.read(buffer.data(), buffer.size()))
+        {
+            throw std::runtime_error("can't read wavefront.obj file");
+        }
+        return buffer;
+    }
+
+    // Chunk models are never compacted, their indexes stay 32 bit.
+    void copy_indexes(const index_buffer& from, uint32_t* to)
+    {
+        std::copy(from.data32(), from.data32() + from.size(), to);
+    }
+
+    // Chunks below this size are not worth a thread.
+    const size_t min_chunk_bytes = 1 << 20;
+}
+
+model wavefront_obj::read_file(const std::string& path)
+{
+    const std::vector<char> buffer = read_whole_file(path);
+    return parse(buffer.data(), buffer.data() + buffer.size());
+}
+
+model wavefront_obj::read_file(const std::string& path, parallel::thread_pool& pool)
+{
+    const std::vector<char> buffer = read_whole_file(path);
+    return parse(buffer.data(), buffer.data() + buffer.size(), pool);
+}
+
+model wavefront_obj::parse(const char* begin, const char* end)
+{
+    chunk whole;
+    parse_chunk(begin, end, whole); // relative indexes are already global
+    whole.part.drop_invalid_faces();
+    whole.part.compact();
+    whole.part.update_normals();
+    return std::move(whole.part);
+}
+
+model wavefront_obj::parse(const char* begin, const char* end, size_t block_bytes, const progress_type& progress)
+{
+    chunk whole;
+    for (const char* p = begin; p != end;)
+    {
+        const char* block_end = static_cast<size_t>(end - p) > block_bytes ? next_line(p + block_bytes, end) : end;
+        parse_chunk(p, block_end, whole); // appends, relative indexes stay global
+        p = block_end;
+        if (p != end)
+        {
+            progress(whole.part);
+        }
+    }
+    whole.part.drop_invalid_faces();
+    whole.part.compact();
+    whole.part.update_normals();
+    return std::move(whole.part);
+}
+
+model wavefront_obj::parse(const char* begin, const char* end, parallel::thread_pool& pool)
+{
+    const size_t size = end - begin;
+    const size_t count = std::max<size_t>(1, std::min<size_t>(size/min_chunk_bytes, 4*(pool.size() + 1)));
+    if (count == 1)
+    {
+        return parse(begin, end);
+    }
+
+    // chunk i is [bounds[i], bounds[i + 1]), both ends at line starts
+    std::vector<const char*> bounds(count + 1, end);
+    bounds[0] = begin;
+    for (size_t i = 1; i < count; ++i)
+    {
+        bounds[i] = std::max(bounds[i - 1], next_line(begin + size*i/count, end));
+    }
+    std::vector<chunk> chunks(count);
+    pool.parallel_for(count, [&bounds, &chunks](size_t i)
+    {
+        parse_chunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // exclusive prefix sums give every chunk its place in the merged arrays
+    std::vector<size_t> vertexes(count + 1, 0), textures(count + 1, 0), normals(count + 1, 0), faces(count + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        vertexes[i + 1] = vertexes[i] + chunks[i].part.vertexes.size();
+        textures[i + 1] = textures[i] + chunks[i].part.texture_vertexes.size();
+        normals[i + 1] = normals[i] + chunks[i].part.normals.size();
+        faces[i + 1] = faces[i] + chunks[i].part.faces_count();
+    }
+    model new_model;
+    new_model.vertexes.resize(vertexes[count]);
+    new_model.texture_vertexes.resize(textures[count]);
+    new_model.normals.resize(normals[count]);
+    new_model.coord_indexes.resize(3*faces[count]);
+    new_model.texture_indexes.resize(3*faces[count]);
+    new_model.normal_indexes.resize(3*faces[count]);
+    uint32_t* coords = new_model.coord_indexes.wide_data();
+    uint32_t* texture = new_model.texture_indexes.wide_data();
+    uint32_t* normal = new_model.normal_indexes.wide_data();
+    pool.parallel_for(count, [&](size_t i)
+    {
+        const model& part = chunks[i].part;
+        std::copy(part.vertexes.begin(), part.vertexes.end(), new_model.vertexes.begin() + vertexes[i]);
+        std::copy(part.texture_vertexes.begin(), part.texture_vertexes.end(), new_model.texture_vertexes.begin() + textures[i]);
+        std::copy(part.normals.begin(), part.normals.end(), new_model.normals.begin() + normals[i]);
+        copy_indexes(part.coord_indexes, coords + 3*faces[i]);
+        copy_indexes(part.texture_indexes, texture + 3*faces[i]);
+        copy_indexes(part.normal_indexes, normal + 3*faces[i]);
+        for (const relative_fixup& fixup: chunks[i].fixups)
+        {
+            const size_t first = 3*(faces[i] + fixup.face);
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                if (fixup.fields & (1u << (3*corner)))
+                {
+                    coords[first + corner] += vertexes[i];
+                }
+                if (fixup.fields & (1u << (3*corner + 1)))
+                {
+                    texture[first + corner] += textures[i];
+                }
+                if (fixup.fields & (1u << (3*corner + 2)))
+                {
+                    normal[first + corner] += normals[i];
+                }
+            }
+        }
+    });
+    new_model.drop_invalid_faces();
+    new_model.compact();
+    new_model.update_normals();
+    return new_model;
+}
@@ -1,9 +1,12 @@
 #ifndef WAVEFRONT_OBJ
 #define WAVEFRONT_OBJ
 
+#include <functional>
 #include <istream>
+#include <string>
 
 #include "model/model.hpp"
+#include "parallel/thread_pool.hpp"
 
 class wavefront_obj
 {
@@ -19,10 +22,27 @@ public:
         ,face
     };
 
+    typedef std::function<void(const model&)> progress_type;
+
     wavefront_obj() {}
 
     static model read_model(std::istream& input);
 
+    // Reads the whole file in one block and tokenizes it in place, the model
+    // is the same as read_model gives without the per line string streams.
+    static model read_file(const std::string& path);
+    static model parse(const char* begin, const char* end);
+
+    // Same model, the buffer is split at line starts into chunks that are
+    // parsed on the pool and then merged in file order.
+    static model read_file(const std::string& path, parallel::thread_pool& pool);
+    static model parse(const char* begin, const char* end, parallel::thread_pool& pool);
+
+    // Same model again, read in blocks of about block_bytes. After every block
+    // but the last, progress gets what was read so far, indexes not compacted
+    // and normals not updated.
+    static model parse(const char* begin, const char* end, size_t block_bytes, const progress_type& progress);
+
     static line_type parse_line_type(std::string& input);
     static cmn::vec3f read_vertex(const std::string& input);
     static cmn::vec3f read_texture_coords(const std::string& input);
@@ -0,0 +1,181 @@
+#ifndef FIXED_HPP
+#define FIXED_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cmn
+{
+
+// Binary fixed point number, a storage_t integer counting steps of
+// 2^-fraction_bits, so fixed<4> is 28.4 in 32 bits. Addition, subtraction
+// and comparison are exact integer operations, products go through
+// wide_mul into a type with room for the full result, and rounding only
+// happens when a double is converted in. Out of range results throw
+// std::overflow_error in debug builds and are unchecked in release, like
+// the vector range checks.
+template<int fraction_bits, class storage_t = int32_t>
+class fixed
+{
+public:
+    static_assert(std::is_integral<storage_t>::value && std::is_signed<storage_t>::value, "fixed needs a signed integer storage");
+    static_assert(fraction_bits >= 0 && fraction_bits < std::numeric_limits<storage_t>::digits, "fixed fraction does not fit the storage");
+
+    typedef storage_t storage_type;
+
+    static const int fraction = fraction_bits;
+    static const int integer = std::numeric_limits<storage_t>::digits - fraction_bits;
+    static const storage_t one = storage_t(1) << fraction_bits;
+
+    fixed() :
+        _raw(0)
+    {}
+
+    // Integers are exact, floating point values round to the nearest step,
+    // halfway cases away from zero.
+    template<class value_t, class = typename std::enable_if<std::is_arithmetic<value_t>::value>::type>
+    explicit fixed(value_t value) :
+        _raw(convert(value, std::is_integral<value_t>()))
+    {}
+
+    static fixed from_raw(storage_t raw)
+    {
+        fixed result;
+        result._raw = raw;
+        return result;
+    }
+
+    storage_t raw() const
+    {
+        return _raw;
+    }
+
+    double to_double() const
+    {
+        return static_cast<double>(_raw)/one;
+    }
+
+    explicit operator double() const
+    {
+        return to_double();
+    }
+
+    // largest integer not above the value
+    storage_t floor() const
+    {
+        return _raw >> fraction_bits;
+    }
+
+    // smallest integer not below the value
+    storage_t ceil() const
+    {
+        return (checked_add(_raw, one - 1)) >> fraction_bits;
+    }
+
+    fixed operator - () const
+    {
+#ifndef NDEBUG
+        if (_raw == std::numeric_limits<storage_t>::min()) throw std::overflow_error("fixed negation overflow");
+#endif
+        return from_raw(-_raw);
+    }
+
+    fixed operator + (const fixed& that) const
+    {
+        return from_raw(checked_add(_raw, that._raw));
+    }
+
+    fixed operator - (const fixed& that) const
+    {
+        return from_raw(checked_sub(_raw, that._raw));
+    }
+
+    fixed& operator += (const fixed& that)
+    {
+        _raw = checked_add(_raw, that._raw);
+        return *this;
+    }
+
+    fixed& operator -= (const fixed& that)
+    {
+        _raw = checked_sub(_raw, that._raw);
+        return *this;
+    }
+
+    // Exact product in wide_t, with twice the fraction bits.
+    template<class wide_t = int64_t>
+    fixed<2*fraction_bits, wide_t> wide_mul(const fixed& that) const
+    {
+        static_assert(std::numeric_limits<wide_t>::digits >= 2*std::numeric_limits<storage_t>::digits, "wide_mul needs a type twice as wide");
+        return fixed<2*fraction_bits, wide_t>::from_raw(static_cast<wide_t>(_raw)*that._raw);
+    }
+
+    bool operator == (const fixed& that) const { return _raw == that._raw; }
+    bool operator != (const fixed& that) const { return _raw != that._raw; }
+    bool operator < (const fixed& that) const { return _raw < that._raw; }
+    bool operator <= (const fixed& that) const { return _raw <= that._raw; }
+    bool operator > (const fixed& that) const { return _raw > that._raw; }
+    bool operator >= (const fixed& that) const { return _raw >= that._raw; }
+
+private:
+    template<class value_t>
+    static storage_t convert(value_t value, std::true_type)
+    {
+#ifndef NDEBUG
+        const long double checked = value;
+        if (checked > (std::numeric_limits<storage_t>::max() >> fraction_bits)
+            || checked < (std::numeric_limits<storage_t>::min() >> fraction_bits))
+        {
+            throw std::overflow_error("fixed conversion overflow");
+        }
+#endif
+        return static_cast<storage_t>(static_cast<storage_t>(value)*one);
+    }
+
+    template<class value_t>
+    static storage_t convert(value_t value, std::false_type)
+    {
+        const double scaled = static_cast<double>(value)*one;
+#ifndef NDEBUG
+        if (!(scaled >= static_cast<double>(std::numeric_limits<storage_t>::min())
+              && scaled <= static_cast<double>(std::numeric_limits<storage_t>::max())))
+        {
+            throw std::overflow_error("fixed conversion overflow");
+        }
+#endif
+        return static_cast<storage_t>(std::llround(scaled));
+    }
+
+    static storage_t checked_add(storage_t a, storage_t b)
+    {
+#ifndef NDEBUG
+        if ((b > 0 && a > std::numeric_limits<storage_t>::max() - b)
+            || (b < 0 && a < std::numeric_limits<storage_t>::min() - b))
+        {
+            throw std::overflow_error("fixed addition overflow");
+        }
+#endif
+        return static_cast<storage_t>(a + b);
+    }
+
+    static storage_t checked_sub(storage_t a, storage_t b)
+    {
+#ifndef NDEBUG
+        if ((b < 0 && a > std::numeric_limits<storage_t>::max() + b)
+            || (b > 0 && a < std::numeric_limits<storage_t>::min() + b))
+        {
+            throw std::overflow_error("fixed subtraction overflow");
+        }
+#endif
+        return static_cast<storage_t>(a - b);
+    }
+
+    storage_t _raw;
+};
+
+} // end of cmn namespace
+
+#endif // FIXED_HPP
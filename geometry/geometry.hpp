@@ -4,6 +4,12 @@
 #include "vec2.hpp"
 #include "vec3.hpp"
 #include "vecN.hpp"
+#include "vec_simd.hpp"
+#include "fixed.hpp"
+#include "mat3.hpp"
+#include "mat4.hpp"
+#include "quaternion.hpp"
+#include "soa_streams.hpp"
 #include "size2.hpp"
 #include "primitives.hpp"
 
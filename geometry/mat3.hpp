@@ -0,0 +1,99 @@
+#ifndef MAT3_HPP
+#define MAT3_HPP
+
+#include <cstddef>
+
+#include "vec_simd.hpp"
+
+namespace cmn
+{
+
+// Single precision 3x3 matrix stored as three vec3s columns, for rotations
+// and normal transforms.
+class mat3
+{
+public:
+    // identity
+    mat3()
+    {
+        _columns[0] = vec3s(1.0f, 0.0f, 0.0f);
+        _columns[1] = vec3s(0.0f, 1.0f, 0.0f);
+        _columns[2] = vec3s(0.0f, 0.0f, 1.0f);
+    }
+
+    mat3(const vec3s& c0, const vec3s& c1, const vec3s& c2)
+    {
+        _columns[0] = c0;
+        _columns[1] = c1;
+        _columns[2] = c2;
+    }
+
+    const vec3s& column(size_t idx) const
+    {
+        return _columns[idx];
+    }
+
+    vec3s& column(size_t idx)
+    {
+        return _columns[idx];
+    }
+
+    float operator()(size_t row, size_t col) const
+    {
+        return _columns[col][row];
+    }
+
+    float& operator()(size_t row, size_t col)
+    {
+        return _columns[col][row];
+    }
+
+    vec3s operator * (const vec3s& v) const
+    {
+        const simd::float4 r = simd::add(simd::add(simd::mul(_columns[0].lanes(), simd::splat(v.x()))
+                                                   , simd::mul(_columns[1].lanes(), simd::splat(v.y())))
+                                         , simd::mul(_columns[2].lanes(), simd::splat(v.z())));
+        return vec3s(r);
+    }
+
+    mat3 operator * (const mat3& that) const
+    {
+        return mat3((*this)*that._columns[0], (*this)*that._columns[1], (*this)*that._columns[2]);
+    }
+
+    mat3 transposed() const
+    {
+        const mat3& m = *this;
+        return mat3(vec3s(m(0, 0), m(0, 1), m(0, 2))
+                    , vec3s(m(1, 0), m(1, 1), m(1, 2))
+                    , vec3s(m(2, 0), m(2, 1), m(2, 2)));
+    }
+
+    float determinant() const
+    {
+        return _columns[0]*_columns[1].vec_prod(_columns[2]);
+    }
+
+    // The rows of the inverse are the cross products of the columns over the
+    // determinant. Singular matrices give infinities.
+    mat3 inverse() const
+    {
+        const float scale = 1.0f/determinant();
+        return mat3(_columns[1].vec_prod(_columns[2])*scale
+                    , _columns[2].vec_prod(_columns[0])*scale
+                    , _columns[0].vec_prod(_columns[1])*scale).transposed();
+    }
+
+    // Transforms normals the way the matrix transforms positions.
+    mat3 normal_matrix() const
+    {
+        return inverse().transposed();
+    }
+
+private:
+    vec3s _columns[3];
+};
+
+} // end of cmn namespace
+
+#endif // MAT3_HPP
@@ -0,0 +1,174 @@
+#ifndef MAT4_HPP
+#define MAT4_HPP
+
+#include <cmath>
+#include <cstddef>
+
+#include "vec_simd.hpp"
+#include "mat3.hpp"
+
+namespace cmn
+{
+
+// Single precision 4x4 matrix stored as four vec4s columns, for homogeneous
+// transforms. Vectors are columns and multiplied on the right, so a*b applies
+// b first. The camera builders follow the OpenGL conventions: the eye looks
+// down -z and clip z/w runs from -1 at the near plane to 1 at the far one.
+class mat4
+{
+public:
+    // identity
+    mat4()
+    {
+        _columns[0] = vec4s({1.0f, 0.0f, 0.0f, 0.0f});
+        _columns[1] = vec4s({0.0f, 1.0f, 0.0f, 0.0f});
+        _columns[2] = vec4s({0.0f, 0.0f, 1.0f, 0.0f});
+        _columns[3] = vec4s({0.0f, 0.0f, 0.0f, 1.0f});
+    }
+
+    mat4(const vec4s& c0, const vec4s& c1, const vec4s& c2, const vec4s& c3)
+    {
+        _columns[0] = c0;
+        _columns[1] = c1;
+        _columns[2] = c2;
+        _columns[3] = c3;
+    }
+
+    // rotation and scale part of a, no translation
+    explicit mat4(const mat3& a)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const vec3s& column = a.column(c);
+            _columns[c] = vec4s({column.x(), column.y(), column.z(), 0.0f});
+        }
+        _columns[3] = vec4s({0.0f, 0.0f, 0.0f, 1.0f});
+    }
+
+    const vec4s& column(size_t idx) const
+    {
+        return _columns[idx];
+    }
+
+    vec4s& column(size_t idx)
+    {
+        return _columns[idx];
+    }
+
+    float operator()(size_t row, size_t col) const
+    {
+        return _columns[col][row];
+    }
+
+    float& operator()(size_t row, size_t col)
+    {
+        return _columns[col][row];
+    }
+
+    // upper left 3x3
+    mat3 linear() const
+    {
+        const mat4& m = *this;
+        return mat3(vec3s(m(0, 0), m(1, 0), m(2, 0))
+                    , vec3s(m(0, 1), m(1, 1), m(2, 1))
+                    , vec3s(m(0, 2), m(1, 2), m(2, 2)));
+    }
+
+    // Sum of the columns scaled by the splatted coordinates, four
+    // multiply-adds without any horizontal work.
+    simd::float4 transform(simd::float4 x, simd::float4 y, simd::float4 z, simd::float4 w) const
+    {
+        return simd::add(simd::add(simd::mul(_columns[0].lanes(), x), simd::mul(_columns[1].lanes(), y))
+                         , simd::add(simd::mul(_columns[2].lanes(), z), simd::mul(_columns[3].lanes(), w)));
+    }
+
+    vec4s operator * (const vec4s& v) const
+    {
+        return vec4s(transform(simd::splat(v[0]), simd::splat(v[1]), simd::splat(v[2]), simd::splat(v[3])));
+    }
+
+    // point, w = 1
+    vec4s transform_point(float x, float y, float z) const
+    {
+        return vec4s(simd::add(simd::add(simd::mul(_columns[0].lanes(), simd::splat(x)), simd::mul(_columns[1].lanes(), simd::splat(y)))
+                               , simd::add(simd::mul(_columns[2].lanes(), simd::splat(z)), _columns[3].lanes())));
+    }
+
+    mat4 operator * (const mat4& that) const
+    {
+        return mat4((*this)*that._columns[0], (*this)*that._columns[1], (*this)*that._columns[2], (*this)*that._columns[3]);
+    }
+
+    mat4 transposed() const
+    {
+        const mat4& m = *this;
+        return mat4(vec4s({m(0, 0), m(0, 1), m(0, 2), m(0, 3)})
+                    , vec4s({m(1, 0), m(1, 1), m(1, 2), m(1, 3)})
+                    , vec4s({m(2, 0), m(2, 1), m(2, 2), m(2, 3)})
+                    , vec4s({m(3, 0), m(3, 1), m(3, 2), m(3, 3)}));
+    }
+
+    static mat4 translation(const vec3s& offset)
+    {
+        mat4 r;
+        r._columns[3] = vec4s({offset.x(), offset.y(), offset.z(), 1.0f});
+        return r;
+    }
+
+    static mat4 scale(const vec3s& factors)
+    {
+        mat4 r;
+        r(0, 0) = factors.x();
+        r(1, 1) = factors.y();
+        r(2, 2) = factors.z();
+        return r;
+    }
+
+    // World to eye space for an eye at eye looking at center. up must not be
+    // parallel to the view direction.
+    static mat4 look_at(const vec3s& eye, const vec3s& center, const vec3s& up)
+    {
+        const vec3s forward = (center - eye).normalize();
+        const vec3s side = forward.vec_prod(up).normalize();
+        const vec3s camera_up = side.vec_prod(forward);
+        mat4 r(mat3(side, camera_up, -forward).transposed());
+        r._columns[3] = vec4s({-(side*eye), -(camera_up*eye), forward*eye, 1.0f});
+        return r;
+    }
+
+    // fovy in radians, near and far positive distances along -z.
+    static mat4 perspective(float fovy, float aspect, float near, float far)
+    {
+        const float f = 1.0f/std::tan(fovy/2.0f);
+        const float depth = near - far;
+        return mat4(vec4s({f/aspect, 0.0f, 0.0f, 0.0f})
+                    , vec4s({0.0f, f, 0.0f, 0.0f})
+                    , vec4s({0.0f, 0.0f, (far + near)/depth, -1.0f})
+                    , vec4s({0.0f, 0.0f, 2.0f*far*near/depth, 0.0f}));
+    }
+
+    static mat4 orthographic(float left, float right, float bottom, float top, float near, float far)
+    {
+        return mat4(vec4s({2.0f/(right - left), 0.0f, 0.0f, 0.0f})
+                    , vec4s({0.0f, 2.0f/(top - bottom), 0.0f, 0.0f})
+                    , vec4s({0.0f, 0.0f, -2.0f/(far - near), 0.0f})
+                    , vec4s({-(right + left)/(right - left), -(top + bottom)/(top - bottom), -(far + near)/(far - near), 1.0f}));
+    }
+
+    // Normalized device coordinates to pixels of the x, y, width, height
+    // rectangle, z is kept.
+    static mat4 viewport(float x, float y, float width, float height)
+    {
+        return mat4(vec4s({width/2.0f, 0.0f, 0.0f, 0.0f})
+                    , vec4s({0.0f, height/2.0f, 0.0f, 0.0f})
+                    , vec4s({0.0f, 0.0f, 1.0f, 0.0f})
+                    , vec4s({x + width/2.0f, y + height/2.0f, 0.0f, 1.0f}));
+    }
+
+private:
+    vec4s _columns[4];
+};
+
+} // end of cmn namespace
+
+#endif // MAT4_HPP
@@ -0,0 +1,87 @@
+#ifndef QUATERNION_HPP
+#define QUATERNION_HPP
+
+#include <cmath>
+
+#include "vec_simd.hpp"
+#include "mat3.hpp"
+#include "mat4.hpp"
+
+namespace cmn
+{
+
+// Single precision rotation quaternion, vector part in xyz and scalar in w.
+// Orbits are kept as quaternions and turned into a matrix once per frame.
+class quaternion
+{
+public:
+    // no rotation
+    quaternion() :
+        _value({0.0f, 0.0f, 0.0f, 1.0f})
+    {}
+
+    quaternion(float x, float y, float z, float w) :
+        _value({x, y, z, w})
+    {}
+
+    // axis must be unit, angle in radians
+    static quaternion from_axis_angle(const vec3s& axis, float angle)
+    {
+        const float s = std::sin(angle/2.0f);
+        return quaternion(axis.x()*s, axis.y()*s, axis.z()*s, std::cos(angle/2.0f));
+    }
+
+    float x() const { return _value[0]; }
+    float y() const { return _value[1]; }
+    float z() const { return _value[2]; }
+    float w() const { return _value[3]; }
+
+    vec3s vector() const
+    {
+        return vec3s(x(), y(), z());
+    }
+
+    // Hamilton product, a*b rotates by b first.
+    quaternion operator * (const quaternion& that) const
+    {
+        const vec3s a = vector();
+        const vec3s b = that.vector();
+        const vec3s v = b*w() + a*that.w() + a.vec_prod(b);
+        return quaternion(v.x(), v.y(), v.z(), w()*that.w() - a*b);
+    }
+
+    quaternion conjugate() const
+    {
+        return quaternion(-x(), -y(), -z(), w());
+    }
+
+    quaternion normalize() const
+    {
+        const float length = std::sqrt(_value*_value);
+        return quaternion(x()/length, y()/length, z()/length, w()/length);
+    }
+
+    vec3s rotate(const vec3s& v) const
+    {
+        const vec3s u = vector();
+        const vec3s t = u.vec_prod(v)*2.0f;
+        return v + t*w() + u.vec_prod(t);
+    }
+
+    mat3 to_mat3() const
+    {
+        return mat3(rotate(vec3s(1.0f, 0.0f, 0.0f)), rotate(vec3s(0.0f, 1.0f, 0.0f)), rotate(vec3s(0.0f, 0.0f, 1.0f)));
+    }
+
+    mat4 to_mat4() const
+    {
+        return mat4(to_mat3());
+    }
+
+private:
+    vec4s _value;
+};
+
+} // end of cmn namespace
+
+#endif // QUATERNION_HPP
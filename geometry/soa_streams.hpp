@@ -0,0 +1,271 @@
+#ifndef SOA_STREAMS_HPP
+#define SOA_STREAMS_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "vec_simd.hpp"
+#include "mat3.hpp"
+#include "mat4.hpp"
+
+namespace cmn
+{
+
+// N component float vectors stored as one array per component. Every array
+// is 16 byte aligned and padded with zeroes to a whole number of simd
+// batches, so the kernels below load and store full registers without tail
+// loops. Padding lanes take part in the arithmetic, their results are
+// garbage and must be ignored.
+template<size_t N>
+class soa_streams
+{
+public:
+    static const size_t components = N;
+
+    soa_streams() :
+        _size(0)
+    {}
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    size_t batches() const
+    {
+        return _data[0].size();
+    }
+
+    // size rounded up to simd::width
+    size_t padded_size() const
+    {
+        return batches()*simd::width;
+    }
+
+    void resize(size_t size)
+    {
+        _size = size;
+        for (size_t c = 0; c < N; ++c)
+        {
+            _data[c].resize((size + simd::width - 1)/simd::width);
+        }
+    }
+
+    void clear()
+    {
+        resize(0);
+    }
+
+    float* component(size_t c)
+    {
+        return reinterpret_cast<float*>(_data[c].data());
+    }
+
+    const float* component(size_t c) const
+    {
+        return reinterpret_cast<const float*>(_data[c].data());
+    }
+
+    simd::float4 batch(size_t c, size_t idx) const
+    {
+        return simd::load(_data[c][idx].lanes);
+    }
+
+    void set_batch(size_t c, size_t idx, simd::float4 value)
+    {
+        simd::store(_data[c][idx].lanes, value);
+    }
+
+    float get(size_t c, size_t idx) const
+    {
+        return component(c)[idx];
+    }
+
+    void set(size_t c, size_t idx, float value)
+    {
+        component(c)[idx] = value;
+    }
+
+private:
+    // 16 byte alignment is within what the default allocator guarantees
+    class batch_t
+    {
+    public:
+        alignas(16) float lanes[simd::width];
+    };
+
+    size_t _size;
+    std::vector<batch_t> _data[N];
+};
+
+typedef soa_streams<1> soa1;
+typedef soa_streams<3> soa3;
+typedef soa_streams<4> soa4;
+
+// Batch kernels over soa streams, one simd batch of vertexes per operation.
+// Outputs are resized to the input size.
+namespace soa
+{
+    // Rows of m splatted across the lanes, and one batch of points, w = 1,
+    // through them.
+    inline void splat_rows(const mat4& m, simd::float4 (&rows)[4][4])
+    {
+        for (size_t r = 0; r < 4; ++r)
+        {
+            for (size_t c = 0; c < 4; ++c)
+            {
+                rows[r][c] = simd::splat(m(r, c));
+            }
+        }
+    }
+
+    inline void transform_batch(const simd::float4 (&rows)[4][4], simd::float4 x, simd::float4 y, simd::float4 z, soa4& out, size_t b)
+    {
+        for (size_t r = 0; r < 4; ++r)
+        {
+            out.set_batch(r, b, simd::add(simd::add(simd::mul(rows[r][0], x), simd::mul(rows[r][1], y))
+                                          , simd::add(simd::mul(rows[r][2], z), rows[r][3])));
+        }
+    }
+
+    // Points, w = 1, to homogeneous coordinates.
+    inline void transform(const mat4& m, const soa3& points, soa4& out)
+    {
+        simd::float4 rows[4][4];
+        splat_rows(m, rows);
+        out.resize(points.size());
+        for (size_t b = 0; b < points.batches(); ++b)
+        {
+            transform_batch(rows, points.batch(0, b), points.batch(1, b), points.batch(2, b), out, b);
+        }
+    }
+
+    // count points given as interleaved 16 bit x, y, z integers, to
+    // homogeneous coordinates. The integers are converted while a batch is
+    // loaded, so m has to include the dequantization.
+    inline void transform(const mat4& m, const uint16_t* points, size_t count, soa4& out)
+    {
+        simd::float4 rows[4][4];
+        splat_rows(m, rows);
+        out.resize(count);
+        for (size_t b = 0; b < out.batches(); ++b)
+        {
+            alignas(16) float lanes[3][simd::width] = {};
+            const size_t first = b*simd::width;
+            const size_t lanes_count = std::min(simd::width, count - first);
+            for (size_t j = 0; j < lanes_count; ++j)
+            {
+                const uint16_t* p = points + 3*(first + j);
+                lanes[0][j] = p[0];
+                lanes[1][j] = p[1];
+                lanes[2][j] = p[2];
+            }
+            transform_batch(rows, simd::load(lanes[0]), simd::load(lanes[1]), simd::load(lanes[2]), out, b);
+        }
+    }
+
+    // Directions, normals take the mat3::normal_matrix of the point transform.
+    inline void transform(const mat3& m, const soa3& vectors, soa3& out)
+    {
+        simd::float4 rows[3][3];
+        for (size_t r = 0; r < 3; ++r)
+        {
+            for (size_t c = 0; c < 3; ++c)
+            {
+                rows[r][c] = simd::splat(m(r, c));
+            }
+        }
+        out.resize(vectors.size());
+        for (size_t b = 0; b < vectors.batches(); ++b)
+        {
+            const simd::float4 x = vectors.batch(0, b);
+            const simd::float4 y = vectors.batch(1, b);
+            const simd::float4 z = vectors.batch(2, b);
+            for (size_t r = 0; r < 3; ++r)
+            {
+                out.set_batch(r, b, simd::add(simd::add(simd::mul(rows[r][0], x), simd::mul(rows[r][1], y)), simd::mul(rows[r][2], z)));
+            }
+        }
+    }
+
+    inline void dot(const soa3& vectors, const vec3s& v, soa1& out)
+    {
+        const simd::float4 vx = simd::splat(v.x());
+        const simd::float4 vy = simd::splat(v.y());
+        const simd::float4 vz = simd::splat(v.z());
+        out.resize(vectors.size());
+        for (size_t b = 0; b < vectors.batches(); ++b)
+        {
+            out.set_batch(0, b, simd::add(simd::add(simd::mul(vectors.batch(0, b), vx), simd::mul(vectors.batch(1, b), vy))
+                                          , simd::mul(vectors.batch(2, b), vz)));
+        }
+    }
+
+    // Zero vectors, padding included, stay zero.
+    inline void normalize(soa3& vectors)
+    {
+        const simd::float4 tiny = simd::splat(1e-30f);
+        for (size_t b = 0; b < vectors.batches(); ++b)
+        {
+            const simd::float4 x = vectors.batch(0, b);
+            const simd::float4 y = vectors.batch(1, b);
+            const simd::float4 z = vectors.batch(2, b);
+            const simd::float4 squared = simd::add(simd::add(simd::mul(x, x), simd::mul(y, y)), simd::mul(z, z));
+            const simd::float4 length = simd::sqrt(simd::max(squared, tiny));
+            vectors.set_batch(0, b, simd::div(x, length));
+            vectors.set_batch(1, b, simd::div(y, length));
+            vectors.set_batch(2, b, simd::div(z, length));
+        }
+    }
+
+    // Axis aligned bounding box, low and high stay untouched when points is
+    // empty. Only the last batch has padding, it is reduced lane by lane.
+    inline void bounds(const soa3& points, vec3s& low, vec3s& high)
+    {
+        if (points.empty())
+        {
+            return;
+        }
+        const size_t full = points.size()/simd::width;
+        simd::float4 lows[3], highs[3];
+        for (size_t c = 0; c < 3; ++c)
+        {
+            lows[c] = simd::splat(points.get(c, 0));
+            highs[c] = lows[c];
+            for (size_t b = 0; b < full; ++b)
+            {
+                lows[c] = simd::min(lows[c], points.batch(c, b));
+                highs[c] = simd::max(highs[c], points.batch(c, b));
+            }
+        }
+        for (size_t c = 0; c < 3; ++c)
+        {
+            alignas(16) float l[simd::width], h[simd::width];
+            simd::store(l, lows[c]);
+            simd::store(h, highs[c]);
+            for (size_t i = full*simd::width; i < points.size(); ++i)
+            {
+                l[0] = std::min(l[0], points.get(c, i));
+                h[0] = std::max(h[0], points.get(c, i));
+            }
+            for (size_t j = 1; j < simd::width; ++j)
+            {
+                l[0] = std::min(l[0], l[j]);
+                h[0] = std::max(h[0], h[j]);
+            }
+            low[c] = l[0];
+            high[c] = h[0];
+        }
+    }
+}
+
+} // end of cmn namespace
+
+#endif // SOA_STREAMS_HPP
@@ -11,6 +11,8 @@
 
 #include <ostream>
 
+#include "vec_expr.hpp"
+
 namespace cmn
 {
 
@@ -41,6 +43,10 @@ public:
         }
     }
 
+    // components left uninitialized, for vectors written in full right after
+    explicit vec2(uninitialized_t)
+    {}
+
     vec2(const value_type& x, const value_type& y)
     {
        (*this).x() = x;
@@ -53,6 +59,20 @@ public:
     vec2(vec2&& that) = default;
     vec2& operator=(vec2&& that) = default;
 
+    // Evaluates an expression node in one pass over the components.
+    template<class expr_t>
+    vec2(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+    }
+
+    template<class expr_t>
+    vec2<value_type>& operator=(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+        return *this;
+    }
+
     template<class that_value_type>
     vec2(const vec2<that_value_type>& that)
     {
@@ -122,13 +142,17 @@ public:
 
     reference& operator[](const size_type& idx)
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vec2 out of range error");
+#endif
         return _data[idx];
     }
 
     const_reference& operator[](const size_type& idx) const
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vec2 out of range error");
+#endif
         return _data[idx];
     }
 
@@ -171,37 +195,6 @@ public:
         _data.swap(that._data);
     }
 
-    vec2<value_type> operator - () const
-    {
-        vec2<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(), std::negate<value_type>());
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator + (const vec2<that_value_type>& that) const
-    {
-        vec2<return_value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f + s;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator - (const vec2<that_value_type>& that) const
-    {
-        vec2<return_value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f - s;
-        });
-        return tmp;
-    }
-
     template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
     vec2<return_value_type>& operator += (const vec2<that_value_type>& that)
     {
@@ -224,31 +217,30 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator + (const that_value_type& value) const
+    template<class expr_t>
+    vec2<value_type>& operator += (const vec_expr<expr_t>& expr)
     {
-        vec2<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val + (return_value_type)value;
-        });
-        return tmp;
+            _data[i] += static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator - (const that_value_type& value) const
+    template<class expr_t>
+    vec2<value_type>& operator -= (const vec_expr<expr_t>& expr)
     {
-        vec2<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val - (return_value_type)value;
-        });
-        return tmp;
+            _data[i] -= static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec2<return_value_type> operator += (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -259,7 +251,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec2<return_value_type> operator -= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -270,31 +263,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator * (const that_value_type& value) const
-    {
-        vec2<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val * (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec2<return_value_type> operator / (const that_value_type& value) const
-    {
-        vec2<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val / (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec2<return_value_type> operator *= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -305,7 +275,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec2<return_value_type> operator /= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -316,12 +287,6 @@ public:
         return *this;
     }
 
-    template<class that_value_type>
-    double operator * (const vec2<that_value_type>& that) const
-    {
-        return (*this).prod(that);
-    }
-
     double prod(const vec2<value_type>& that) const
     {
         return  std::inner_product((*this).begin(), (*this).end(), that.begin(), 0.0);
@@ -396,6 +361,16 @@ public:
     }
 
 private:
+    template<class expr_t>
+    void assign(const expr_t& e)
+    {
+        static_assert(expr_t::dims == dims, "vector dimensions mismatch");
+        for (size_type i = 0; i < dims; ++i)
+        {
+            _data[i] = static_cast<value_type>(e[i]);
+        }
+    }
+
     store_type _data;
 };
 
@@ -417,25 +392,4 @@ std::ostream& operator << (std::ostream& out, const cmn::vec2<value_type>& vecto
     return out;
 }
 
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec2<return_value_type> operator + (const that_value_type& val, const cmn::vec2<value_type>& v)
-{
-    return (v + val);
-}
-
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec2<return_value_type> operator - (const that_value_type& val, const cmn::vec2<value_type>& v)
-{
-    return -(v - val);
-}
-
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec2<return_value_type> operator * (const that_value_type& val, const cmn::vec2<value_type>& v)
-{
-    return (v * val);
-}
-
 #endif // VEC2_HPP
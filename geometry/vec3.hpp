@@ -11,6 +11,8 @@
 
 #include <ostream>
 
+#include "vec_expr.hpp"
+
 namespace cmn
 {
 
@@ -42,6 +44,10 @@ public:
         }
     }
 
+    // components left uninitialized, for vectors written in full right after
+    explicit vec3(uninitialized_t)
+    {}
+
     vec3(const value_type& x, const value_type& y, const value_type& z)
     {
        (*this).x() = x;
@@ -55,6 +61,20 @@ public:
     vec3(vec3&& that) = default;
     vec3& operator=(vec3&& that) = default;
 
+    // Evaluates an expression node in one pass over the components.
+    template<class expr_t>
+    vec3(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+    }
+
+    template<class expr_t>
+    vec3<value_type>& operator=(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+        return *this;
+    }
+
     template<class that_value_type>
     vec3(const vec3<that_value_type>& that)
     {
@@ -124,13 +144,17 @@ public:
 
     reference& operator[](const size_type& idx)
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vec3 out of range error");
+#endif
         return _data[idx];
     }
 
     const_reference& operator[](const size_type& idx) const
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vec3 out of range error");
+#endif
         return _data[idx];
     }
 
@@ -173,37 +197,6 @@ public:
         _data.swap(that._data);
     }
 
-    vec3<value_type> operator - () const
-    {
-        vec3<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(), std::negate<value_type>());
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator + (const vec3<that_value_type>& that) const
-    {
-        vec3<return_value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f + s;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator - (const vec3<that_value_type>& that) const
-    {
-        vec3<return_value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f - s;
-        });
-        return tmp;
-    }
-
     template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
     vec3<return_value_type>& operator += (const vec3<that_value_type>& that)
     {
@@ -226,31 +219,30 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator + (const that_value_type& value) const
+    template<class expr_t>
+    vec3<value_type>& operator += (const vec_expr<expr_t>& expr)
     {
-        vec3<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val + (return_value_type)value;
-        });
-        return tmp;
+            _data[i] += static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator - (const that_value_type& value) const
+    template<class expr_t>
+    vec3<value_type>& operator -= (const vec_expr<expr_t>& expr)
     {
-        vec3<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val - (return_value_type)value;
-        });
-        return tmp;
+            _data[i] -= static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec3<return_value_type> operator += (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -261,7 +253,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec3<return_value_type> operator -= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -272,31 +265,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator * (const that_value_type& value) const
-    {
-        vec3<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val * (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vec3<return_value_type> operator / (const that_value_type& value) const
-    {
-        vec3<value_type> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val / (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec3<return_value_type> operator *= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -307,7 +277,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vec3<return_value_type> operator /= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -318,12 +289,6 @@ public:
         return *this;
     }
 
-    template<class that_value_type>
-    double operator * (const vec3<that_value_type>& that) const
-    {
-        return (*this).prod(that);
-    }
-
     double prod(const vec3<value_type>& that) const
     {
         return  std::inner_product((*this).begin(), (*this).end(), that.begin(), 0.0);
@@ -420,6 +385,16 @@ public:
     }
 
 private:
+    template<class expr_t>
+    void assign(const expr_t& e)
+    {
+        static_assert(expr_t::dims == dims, "vector dimensions mismatch");
+        for (size_type i = 0; i < dims; ++i)
+        {
+            _data[i] = static_cast<value_type>(e[i]);
+        }
+    }
+
     store_type _data;
 };
 
@@ -441,25 +416,7 @@ std::ostream& operator << (std::ostream& out, const cmn::vec3<value_type>& vecto
     return out;
 }
 
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec3<return_value_type> operator + (const that_value_type& val, const cmn::vec3<value_type>& v)
-{
-    return (v + val);
-}
-
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec3<return_value_type> operator - (const that_value_type& val, const cmn::vec3<value_type>& v)
-{
-    return -(v - val);
-}
-
-template<class value_type, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vec3<return_value_type> operator * (const that_value_type& val, const cmn::vec3<value_type>& v)
-{
-    return (v * val);
-}
+// The float specializations have to be seen by every user of the template.
+#include "vec_simd.hpp"
 
 #endif // VEC3_HPP
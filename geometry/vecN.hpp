@@ -11,6 +11,8 @@
 
 #include <ostream>
 
+#include "vec_expr.hpp"
+
 namespace cmn
 {
 
@@ -39,12 +41,30 @@ public:
         }
     }
 
+    // components left uninitialized, for vectors written in full right after
+    explicit vecn(uninitialized_t)
+    {}
+
     vecn(const vecn& that) = default;
     vecn& operator=(const vecn& that) = default;
 
     vecn(vecn&& that) = default;
     vecn& operator=(vecn&& that) = default;
 
+    // Evaluates an expression node in one pass over the components.
+    template<class expr_t>
+    vecn(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+    }
+
+    template<class expr_t>
+    vecn<value_type, dims>& operator=(const vec_expr<expr_t>& expr)
+    {
+        assign(expr.derived());
+        return *this;
+    }
+
     template<class that_value_type>
     vecn(const vecn<that_value_type, dims>& that)
     {
@@ -114,13 +134,17 @@ public:
 
     reference& operator[](const size_type& idx)
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vecn out of range error");
+#endif
         return _data[idx];
     }
 
     const_reference& operator[](const size_type& idx) const
     {
+#ifndef NDEBUG
         if (idx >= size()) throw std::out_of_range("vecn out of range error");
+#endif
         return _data[idx];
     }
 
@@ -163,37 +187,6 @@ public:
         _data.swap(that._data);
     }
 
-    vecn<value_type, dims> operator - () const
-    {
-        vecn<value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(), std::negate<value_type>());
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator + (const vecn<that_value_type, dims>& that) const
-    {
-        vecn<return_value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f + s;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator - (const vecn<that_value_type, dims>& that) const
-    {
-        vecn<return_value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), that.begin(), tmp.begin(),
-                     [](const return_value_type& f, const return_value_type& s) -> return_value_type
-        {
-            return f - s;
-        });
-        return tmp;
-    }
-
     template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
     vecn<return_value_type, dims>& operator += (const vecn<that_value_type, dims>& that)
     {
@@ -216,31 +209,30 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator + (const that_value_type& value) const
+    template<class expr_t>
+    vecn<value_type, dims>& operator += (const vec_expr<expr_t>& expr)
     {
-        vecn<value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val + (return_value_type)value;
-        });
-        return tmp;
+            _data[i] += static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator - (const that_value_type& value) const
+    template<class expr_t>
+    vecn<value_type, dims>& operator -= (const vec_expr<expr_t>& expr)
     {
-        vecn<value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
+        const expr_t& e = expr.derived();
+        for (size_type i = 0; i < dims; ++i)
         {
-            return val - (return_value_type)value;
-        });
-        return tmp;
+            _data[i] -= static_cast<value_type>(e[i]);
+        }
+        return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vecn<return_value_type, dims> operator += (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -251,7 +243,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vecn<return_value_type, dims> operator -= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -262,31 +255,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator * (const that_value_type& value) const
-    {
-        vecn<value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val * (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
-    vecn<return_value_type, dims> operator / (const that_value_type& value) const
-    {
-        vecn<value_type, dims> tmp;
-        std::transform((*this).begin(), (*this).end(), tmp.begin(),
-                     [&value](const return_value_type& val) -> return_value_type
-        {
-            return val / (return_value_type)value;
-        });
-        return tmp;
-    }
-
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vecn<return_value_type, dims> operator *= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -297,7 +267,8 @@ public:
         return *this;
     }
 
-    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type>
+    template<class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
+             , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
     vecn<return_value_type, dims> operator /= (const that_value_type& value)
     {
         std::transform((*this).begin(), (*this).end(), (*this).begin(),
@@ -308,12 +279,6 @@ public:
         return *this;
     }
 
-    template<class that_value_type>
-    double operator * (const vecn<that_value_type, dims>& that) const
-    {
-        return (*this).prod(that);
-    }
-
     double prod(const vecn<value_type, dims>& that) const
     {
         return  std::inner_product((*this).begin(), (*this).end(), that.begin(), 0.0);
@@ -368,6 +333,16 @@ public:
     }
 
 private:
+    template<class expr_t>
+    void assign(const expr_t& e)
+    {
+        static_assert(expr_t::dims == dims, "vector dimensions mismatch");
+        for (size_type i = 0; i < dims; ++i)
+        {
+            _data[i] = static_cast<value_type>(e[i]);
+        }
+    }
+
     store_type _data;
 };
 
@@ -386,25 +361,7 @@ std::ostream& operator << (std::ostream& out, const cmn::vecn<value_type, dims>&
     return out;
 }
 
-template<class value_type, size_t dims, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vecn<return_value_type, dims> operator + (const that_value_type& val, const cmn::vecn<value_type, dims>& v)
-{
-    return (v + val);
-}
-
-template<class value_type, size_t dims, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vecn<return_value_type, dims> operator - (const that_value_type& val, const cmn::vecn<value_type, dims>& v)
-{
-    return -(v - val);
-}
-
-template<class value_type, size_t dims, class that_value_type, class return_value_type = typename std::common_type<value_type, that_value_type>::type
-         , class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
-cmn::vecn<return_value_type, dims> operator * (const that_value_type& val, const cmn::vecn<value_type, dims>& v)
-{
-    return (v * val);
-}
+// The float specializations have to be seen by every user of the template.
+#include "vec_simd.hpp"
 
 #endif // VECN_HPP
@@ -0,0 +1,306 @@
+#ifndef VEC_EXPR_HPP
+#define VEC_EXPR_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+namespace cmn
+{
+
+template<class T> class vec2;
+template<class T> class vec3;
+template<class T, size_t N> class vecn;
+
+// Tag for the vector constructors that leave the components uninitialized,
+// for hot paths that write every component right after.
+class uninitialized_t {};
+const uninitialized_t uninitialized = uninitialized_t();
+
+// Arithmetic on vec2, vec3 and vecn builds expression nodes instead of
+// vectors. A node is evaluated component by component when it is assigned
+// or converted to a vector, so a + (b - a)*t runs as one loop with no
+// temporaries. Nodes keep references to the vectors they read: store the
+// result in a vector, not in an auto variable. Dot products are evaluated
+// at once. The float simd specializations keep their register arithmetic.
+template<class expr_t>
+class vec_expr
+{
+public:
+    const expr_t& derived() const
+    {
+        return static_cast<const expr_t&>(*this);
+    }
+
+    template<class E = expr_t>
+    typename E::result_type eval() const
+    {
+        return typename E::result_type(derived());
+    }
+
+    template<class E = expr_t>
+    typename E::value_type x() const
+    {
+        return derived()[0];
+    }
+
+    template<class E = expr_t>
+    typename E::value_type y() const
+    {
+        return derived()[1];
+    }
+
+    template<class E = expr_t>
+    typename E::value_type z() const
+    {
+        return derived()[2];
+    }
+
+    double norm() const
+    {
+        return eval().norm();
+    }
+
+    template<class that_t, class E = expr_t>
+    typename E::result_type vec_prod(const that_t& that) const
+    {
+        return eval().vec_prod(that);
+    }
+
+    template<class E = expr_t>
+    typename E::result_type normalize() const
+    {
+        return eval().normalize();
+    }
+};
+
+// Vectors that take part in expressions.
+template<class vec_t>
+class vec_leaf : public std::false_type {};
+
+template<class T>
+class vec_leaf<vec2<T>> : public std::true_type
+{
+public:
+    template<class U> using rebind = vec2<U>;
+};
+
+template<class T>
+class vec_leaf<vec3<T>> : public std::true_type
+{
+public:
+    template<class U> using rebind = vec3<U>;
+};
+
+template<class T, size_t N>
+class vec_leaf<vecn<T, N>> : public std::true_type
+{
+public:
+    template<class U> using rebind = vecn<U, N>;
+};
+
+template<>
+class vec_leaf<vec3<float>> : public std::false_type {};
+
+template<>
+class vec_leaf<vecn<float, 4>> : public std::false_type {};
+
+// Vectors are held by reference and nodes by value.
+template<class operand_t, bool leaf = vec_leaf<operand_t>::value, bool expr = std::is_base_of<vec_expr<operand_t>, operand_t>::value>
+class vec_operand : public std::false_type {};
+
+template<class operand_t>
+class vec_operand<operand_t, true, false> : public std::true_type
+{
+public:
+    typedef const operand_t& storage;
+    template<class U> using rebind = typename vec_leaf<operand_t>::template rebind<U>;
+};
+
+template<class operand_t>
+class vec_operand<operand_t, false, true> : public std::true_type
+{
+public:
+    typedef operand_t storage;
+    template<class U> using rebind = typename operand_t::template rebind<U>;
+};
+
+class vec_add
+{
+public:
+    template<class T> static T apply(const T& a, const T& b) { return a + b; }
+};
+
+class vec_sub
+{
+public:
+    template<class T> static T apply(const T& a, const T& b) { return a - b; }
+};
+
+class vec_mul
+{
+public:
+    template<class T> static T apply(const T& a, const T& b) { return a*b; }
+};
+
+class vec_div
+{
+public:
+    template<class T> static T apply(const T& a, const T& b) { return a/b; }
+};
+
+template<class lhs_t, class rhs_t, class op_t>
+class vec_binary : public vec_expr<vec_binary<lhs_t, rhs_t, op_t>>
+{
+public:
+    static_assert(lhs_t::dims == rhs_t::dims, "vector dimensions mismatch");
+
+    typedef typename std::common_type<typename lhs_t::value_type, typename rhs_t::value_type>::type value_type;
+    static const size_t dims = lhs_t::dims;
+    template<class U> using rebind = typename vec_operand<lhs_t>::template rebind<U>;
+    typedef rebind<value_type> result_type;
+
+    vec_binary(const lhs_t& lhs, const rhs_t& rhs) :
+        _lhs(lhs)
+      , _rhs(rhs)
+    {}
+
+    value_type operator[](size_t idx) const
+    {
+        return op_t::apply(static_cast<value_type>(_lhs[idx]), static_cast<value_type>(_rhs[idx]));
+    }
+
+private:
+    typename vec_operand<lhs_t>::storage _lhs;
+    typename vec_operand<rhs_t>::storage _rhs;
+};
+
+// vector op scalar, or scalar op vector when scalar_first
+template<class vec_t, class scalar_t, class op_t, bool scalar_first>
+class vec_scalar : public vec_expr<vec_scalar<vec_t, scalar_t, op_t, scalar_first>>
+{
+public:
+    typedef typename std::common_type<typename vec_t::value_type, scalar_t>::type value_type;
+    static const size_t dims = vec_t::dims;
+    template<class U> using rebind = typename vec_operand<vec_t>::template rebind<U>;
+    typedef rebind<value_type> result_type;
+
+    vec_scalar(const vec_t& v, const scalar_t& s) :
+        _v(v)
+      , _s(static_cast<value_type>(s))
+    {}
+
+    value_type operator[](size_t idx) const
+    {
+        return scalar_first ? op_t::apply(_s, static_cast<value_type>(_v[idx]))
+                            : op_t::apply(static_cast<value_type>(_v[idx]), _s);
+    }
+
+private:
+    typename vec_operand<vec_t>::storage _v;
+    value_type _s;
+};
+
+template<class vec_t>
+class vec_negate : public vec_expr<vec_negate<vec_t>>
+{
+public:
+    typedef typename vec_t::value_type value_type;
+    static const size_t dims = vec_t::dims;
+    template<class U> using rebind = typename vec_operand<vec_t>::template rebind<U>;
+    typedef rebind<value_type> result_type;
+
+    explicit vec_negate(const vec_t& v) :
+        _v(v)
+    {}
+
+    value_type operator[](size_t idx) const
+    {
+        return -static_cast<value_type>(_v[idx]);
+    }
+
+private:
+    typename vec_operand<vec_t>::storage _v;
+};
+
+template<class lhs_t, class rhs_t>
+using vec_operands = typename std::enable_if<vec_operand<lhs_t>::value && vec_operand<rhs_t>::value>::type;
+
+template<class vec_t, class scalar_t>
+using vec_and_scalar = typename std::enable_if<vec_operand<vec_t>::value && std::is_arithmetic<scalar_t>::value>::type;
+
+template<class lhs_t, class rhs_t, class = vec_operands<lhs_t, rhs_t>>
+inline vec_binary<lhs_t, rhs_t, vec_add> operator + (const lhs_t& lhs, const rhs_t& rhs)
+{
+    return vec_binary<lhs_t, rhs_t, vec_add>(lhs, rhs);
+}
+
+template<class lhs_t, class rhs_t, class = vec_operands<lhs_t, rhs_t>>
+inline vec_binary<lhs_t, rhs_t, vec_sub> operator - (const lhs_t& lhs, const rhs_t& rhs)
+{
+    return vec_binary<lhs_t, rhs_t, vec_sub>(lhs, rhs);
+}
+
+// dot product, accumulated in double
+template<class lhs_t, class rhs_t, class = vec_operands<lhs_t, rhs_t>>
+inline double operator * (const lhs_t& lhs, const rhs_t& rhs)
+{
+    static_assert(lhs_t::dims == rhs_t::dims, "vector dimensions mismatch");
+    double sum = lhs[0]*rhs[0];
+    for (size_t i = 1; i < lhs_t::dims; ++i)
+    {
+        sum += lhs[i]*rhs[i];
+    }
+    return sum;
+}
+
+template<class vec_t, class = typename std::enable_if<vec_operand<vec_t>::value>::type>
+inline vec_negate<vec_t> operator - (const vec_t& v)
+{
+    return vec_negate<vec_t>(v);
+}
+
+template<class vec_t, class scalar_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_add, false> operator + (const vec_t& v, const scalar_t& s)
+{
+    return vec_scalar<vec_t, scalar_t, vec_add, false>(v, s);
+}
+
+template<class vec_t, class scalar_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_sub, false> operator - (const vec_t& v, const scalar_t& s)
+{
+    return vec_scalar<vec_t, scalar_t, vec_sub, false>(v, s);
+}
+
+template<class vec_t, class scalar_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_mul, false> operator * (const vec_t& v, const scalar_t& s)
+{
+    return vec_scalar<vec_t, scalar_t, vec_mul, false>(v, s);
+}
+
+template<class vec_t, class scalar_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_div, false> operator / (const vec_t& v, const scalar_t& s)
+{
+    return vec_scalar<vec_t, scalar_t, vec_div, false>(v, s);
+}
+
+template<class scalar_t, class vec_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_add, true> operator + (const scalar_t& s, const vec_t& v)
+{
+    return vec_scalar<vec_t, scalar_t, vec_add, true>(v, s);
+}
+
+template<class scalar_t, class vec_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_sub, true> operator - (const scalar_t& s, const vec_t& v)
+{
+    return vec_scalar<vec_t, scalar_t, vec_sub, true>(v, s);
+}
+
+template<class scalar_t, class vec_t, class = vec_and_scalar<vec_t, scalar_t>>
+inline vec_scalar<vec_t, scalar_t, vec_mul, true> operator * (const scalar_t& s, const vec_t& v)
+{
+    return vec_scalar<vec_t, scalar_t, vec_mul, true>(v, s);
+}
+
+} // end of cmn namespace
+
+#endif // VEC_EXPR_HPP
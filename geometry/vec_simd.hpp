@@ -0,0 +1,522 @@
+#ifndef VEC_SIMD_HPP
+#define VEC_SIMD_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CMN_SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define CMN_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#include "vec3.hpp"
+#include "vecN.hpp"
+
+namespace cmn
+{
+
+// Four float lanes in one register, SSE2 on x86, NEON on aarch64, plain
+// arrays elsewhere. Loads and stores take 16 byte aligned pointers.
+namespace simd
+{
+
+// lanes per float4
+const size_t width = 4;
+
+#if defined(CMN_SIMD_SSE)
+
+typedef __m128 float4;
+
+inline float4 load(const float* p) { return _mm_load_ps(p); }
+inline void store(float* p, float4 v) { _mm_store_ps(p, v); }
+inline float4 splat(float v) { return _mm_set1_ps(v); }
+inline float4 add(float4 a, float4 b) { return _mm_add_ps(a, b); }
+inline float4 sub(float4 a, float4 b) { return _mm_sub_ps(a, b); }
+inline float4 mul(float4 a, float4 b) { return _mm_mul_ps(a, b); }
+inline float4 div(float4 a, float4 b) { return _mm_div_ps(a, b); }
+inline float4 min(float4 a, float4 b) { return _mm_min_ps(a, b); }
+inline float4 max(float4 a, float4 b) { return _mm_max_ps(a, b); }
+inline float4 negate(float4 a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+inline float4 abs(float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline float4 sqrt(float4 a) { return _mm_sqrt_ps(a); }
+
+// (y, z, x, w)
+inline float4 rotate3(float4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)); }
+
+inline float sum3(float4 a)
+{
+    const float4 y = _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1));
+    const float4 z = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2));
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(a, y), z));
+}
+
+inline float sum4(float4 a)
+{
+    const float4 pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+
+#elif defined(CMN_SIMD_NEON)
+
+typedef float32x4_t float4;
+
+inline float4 load(const float* p) { return vld1q_f32(p); }
+inline void store(float* p, float4 v) { vst1q_f32(p, v); }
+inline float4 splat(float v) { return vdupq_n_f32(v); }
+inline float4 add(float4 a, float4 b) { return vaddq_f32(a, b); }
+inline float4 sub(float4 a, float4 b) { return vsubq_f32(a, b); }
+inline float4 mul(float4 a, float4 b) { return vmulq_f32(a, b); }
+inline float4 div(float4 a, float4 b) { return vdivq_f32(a, b); }
+inline float4 min(float4 a, float4 b) { return vminq_f32(a, b); }
+inline float4 max(float4 a, float4 b) { return vmaxq_f32(a, b); }
+inline float4 negate(float4 a) { return vnegq_f32(a); }
+inline float4 abs(float4 a) { return vabsq_f32(a); }
+inline float4 sqrt(float4 a) { return vsqrtq_f32(a); }
+
+inline float4 rotate3(float4 a)
+{
+    const float4 yzwx = vextq_f32(a, a, 1);
+    return vsetq_lane_f32(vgetq_lane_f32(a, 0), vsetq_lane_f32(vgetq_lane_f32(a, 3), yzwx, 3), 2);
+}
+
+inline float sum3(float4 a)
+{
+    return vgetq_lane_f32(a, 0) + vgetq_lane_f32(a, 1) + vgetq_lane_f32(a, 2);
+}
+
+inline float sum4(float4 a)
+{
+    return vaddvq_f32(a);
+}
+
+#else
+
+class float4
+{
+public:
+    float lanes[4];
+};
+
+template<class operation_t>
+inline float4 lanewise(const float4& a, const float4& b, operation_t operation)
+{
+    float4 r;
+    for (int i = 0; i < 4; ++i)
+    {
+        r.lanes[i] = operation(a.lanes[i], b.lanes[i]);
+    }
+    return r;
+}
+
+inline float4 load(const float* p) { float4 r; for (int i = 0; i < 4; ++i) r.lanes[i] = p[i]; return r; }
+inline void store(float* p, const float4& v) { for (int i = 0; i < 4; ++i) p[i] = v.lanes[i]; }
+inline float4 splat(float v) { float4 r; for (int i = 0; i < 4; ++i) r.lanes[i] = v; return r; }
+inline float4 add(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return f + s; }); }
+inline float4 sub(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return f - s; }); }
+inline float4 mul(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return f*s; }); }
+inline float4 div(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return f/s; }); }
+inline float4 min(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return s < f ? s : f; }); }
+inline float4 max(const float4& a, const float4& b) { return lanewise(a, b, [](float f, float s) { return f < s ? s : f; }); }
+inline float4 negate(const float4& a) { return sub(splat(0.0f), a); }
+inline float4 abs(const float4& a) { return max(a, negate(a)); }
+inline float4 sqrt(const float4& a) { float4 r; for (int i = 0; i < 4; ++i) r.lanes[i] = std::sqrt(a.lanes[i]); return r; }
+
+inline float4 rotate3(const float4& a)
+{
+    float4 r = {{a.lanes[1], a.lanes[2], a.lanes[0], a.lanes[3]}};
+    return r;
+}
+
+inline float sum3(const float4& a) { return a.lanes[0] + a.lanes[1] + a.lanes[2]; }
+inline float sum4(const float4& a) { return a.lanes[0] + a.lanes[1] + a.lanes[2] + a.lanes[3]; }
+
+#endif
+
+} // end of namespace simd
+
+// Single precision 3d vector in one 16 byte register, the fourth lane is
+// kept at zero. Same interface as vec3, but arithmetic stays in float and
+// runs on the simd lanes.
+template<>
+class vec3<float>
+{
+public:
+    static const size_t dims = 3;
+    static const size_t x_idx = 0;
+    static const size_t y_idx = 1;
+    static const size_t z_idx = 2;
+
+    typedef float value_type;
+    typedef float& reference;
+    typedef const float& const_reference;
+    typedef float* pointer;
+    typedef const float* const_pointer;
+    typedef float* iterator;
+    typedef const float* const_iterator;
+    typedef std::ptrdiff_t difference_type;
+    typedef size_t size_type;
+
+    vec3()
+    {
+        simd::store(_data, simd::splat(0.0f));
+    }
+
+    vec3(const value_type& x, const value_type& y, const value_type& z)
+    {
+        _data[x_idx] = x;
+        _data[y_idx] = y;
+        _data[z_idx] = z;
+        _data[3] = 0.0f;
+    }
+
+    explicit vec3(const simd::float4& lanes)
+    {
+        simd::store(_data, lanes);
+    }
+
+    vec3(const vec3& that) = default;
+    vec3& operator=(const vec3& that) = default;
+
+    template<class that_value_type>
+    vec3(const vec3<that_value_type>& that) :
+        vec3(static_cast<float>(that.x()), static_cast<float>(that.y()), static_cast<float>(that.z()))
+    {}
+
+    template<class that_value_type>
+    vec3(const std::initializer_list<that_value_type>& init)
+    {
+        if (init.size() != dims)
+        {
+            throw std::length_error("vec3 initializer list size mismatch.");
+        }
+        std::copy(init.begin(), init.end(), _data);
+        _data[3] = 0.0f;
+    }
+
+    simd::float4 lanes() const
+    {
+        return simd::load(_data);
+    }
+
+    reference operator[](const size_type& idx)
+    {
+#ifndef NDEBUG
+        if (idx >= dims) throw std::out_of_range("vec3 out of range error");
+#endif
+        return _data[idx];
+    }
+
+    const_reference operator[](const size_type& idx) const
+    {
+#ifndef NDEBUG
+        if (idx >= dims) throw std::out_of_range("vec3 out of range error");
+#endif
+        return _data[idx];
+    }
+
+    size_type size() const
+    {
+        return dims;
+    }
+
+    bool operator == (const vec3& that) const
+    {
+        return x() == that.x() && y() == that.y() && z() == that.z();
+    }
+
+    bool operator != (const vec3& that) const
+    {
+        return !(*this == that);
+    }
+
+    vec3 operator - () const
+    {
+        return vec3(simd::negate(lanes()));
+    }
+
+    vec3 operator + (const vec3& that) const
+    {
+        return vec3(simd::add(lanes(), that.lanes()));
+    }
+
+    vec3 operator - (const vec3& that) const
+    {
+        return vec3(simd::sub(lanes(), that.lanes()));
+    }
+
+    vec3& operator += (const vec3& that)
+    {
+        simd::store(_data, simd::add(lanes(), that.lanes()));
+        return *this;
+    }
+
+    vec3& operator -= (const vec3& that)
+    {
+        simd::store(_data, simd::sub(lanes(), that.lanes()));
+        return *this;
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vec3 operator * (const that_value_type& value) const
+    {
+        return vec3(simd::mul(lanes(), simd::splat(static_cast<float>(value))));
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vec3 operator / (const that_value_type& value) const
+    {
+        return vec3(simd::mul(lanes(), simd::splat(1.0f/static_cast<float>(value))));
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vec3& operator *= (const that_value_type& value)
+    {
+        return *this = *this*value;
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vec3& operator /= (const that_value_type& value)
+    {
+        return *this = *this/value;
+    }
+
+    // dot product
+    float operator * (const vec3& that) const
+    {
+        return prod(that);
+    }
+
+    float prod(const vec3& that) const
+    {
+        return simd::sum3(simd::mul(lanes(), that.lanes()));
+    }
+
+    float norm() const
+    {
+        return std::sqrt(prod(*this));
+    }
+
+    vec3 abs() const
+    {
+        return vec3(simd::abs(lanes()));
+    }
+
+    vec3 vec_prod(const vec3& v) const
+    {
+        const simd::float4 a = lanes();
+        const simd::float4 b = v.lanes();
+        // a x b = (a*b.yzx - a.yzx*b).yzx
+        return vec3(simd::rotate3(simd::sub(simd::mul(a, simd::rotate3(b)), simd::mul(simd::rotate3(a), b))));
+    }
+
+    vec3 normalize(const_reference l = 1.0f) const
+    {
+        return (*this)*(l/norm());
+    }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + dims; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + dims; }
+    const_iterator cbegin() const { return _data; }
+    const_iterator cend() const { return _data + dims; }
+
+    reference x() { return _data[x_idx]; }
+    const_reference x() const { return _data[x_idx]; }
+    reference y() { return _data[y_idx]; }
+    const_reference y() const { return _data[y_idx]; }
+    reference z() { return _data[z_idx]; }
+    const_reference z() const { return _data[z_idx]; }
+
+private:
+    alignas(16) float _data[4];
+};
+
+// Single precision homogeneous vector in one 16 byte register, the
+// vecn<float, 4> of vecN.hpp with float arithmetic on the simd lanes.
+template<>
+class vecn<float, 4>
+{
+public:
+    static const size_t dims = 4;
+
+    typedef float value_type;
+    typedef float& reference;
+    typedef const float& const_reference;
+    typedef float* pointer;
+    typedef const float* const_pointer;
+    typedef float* iterator;
+    typedef const float* const_iterator;
+    typedef std::ptrdiff_t difference_type;
+    typedef size_t size_type;
+
+    vecn()
+    {
+        simd::store(_data, simd::splat(0.0f));
+    }
+
+    explicit vecn(const simd::float4& lanes)
+    {
+        simd::store(_data, lanes);
+    }
+
+    vecn(const vecn& that) = default;
+    vecn& operator=(const vecn& that) = default;
+
+    template<class that_value_type>
+    vecn(const vecn<that_value_type, dims>& that)
+    {
+        std::copy(that.begin(), that.end(), _data);
+    }
+
+    vecn(const std::initializer_list<float>& init)
+    {
+        if (init.size() != dims)
+        {
+            throw std::length_error("vecn initializer list size mismatch.");
+        }
+        std::copy(init.begin(), init.end(), _data);
+    }
+
+    template<class that_value_type>
+    vecn(const std::initializer_list<that_value_type>& init)
+    {
+        if (init.size() != dims)
+        {
+            throw std::length_error("vecn initializer list size mismatch.");
+        }
+        std::copy(init.begin(), init.end(), _data);
+    }
+
+    simd::float4 lanes() const
+    {
+        return simd::load(_data);
+    }
+
+    reference operator[](const size_type& idx)
+    {
+#ifndef NDEBUG
+        if (idx >= dims) throw std::out_of_range("vecn out of range error");
+#endif
+        return _data[idx];
+    }
+
+    const_reference operator[](const size_type& idx) const
+    {
+#ifndef NDEBUG
+        if (idx >= dims) throw std::out_of_range("vecn out of range error");
+#endif
+        return _data[idx];
+    }
+
+    size_type size() const
+    {
+        return dims;
+    }
+
+    bool operator == (const vecn& that) const
+    {
+        return std::equal(begin(), end(), that.begin());
+    }
+
+    bool operator != (const vecn& that) const
+    {
+        return !(*this == that);
+    }
+
+    vecn operator - () const
+    {
+        return vecn(simd::negate(lanes()));
+    }
+
+    vecn operator + (const vecn& that) const
+    {
+        return vecn(simd::add(lanes(), that.lanes()));
+    }
+
+    vecn operator - (const vecn& that) const
+    {
+        return vecn(simd::sub(lanes(), that.lanes()));
+    }
+
+    vecn& operator += (const vecn& that)
+    {
+        simd::store(_data, simd::add(lanes(), that.lanes()));
+        return *this;
+    }
+
+    vecn& operator -= (const vecn& that)
+    {
+        simd::store(_data, simd::sub(lanes(), that.lanes()));
+        return *this;
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vecn operator * (const that_value_type& value) const
+    {
+        return vecn(simd::mul(lanes(), simd::splat(static_cast<float>(value))));
+    }
+
+    template<class that_value_type, class = typename std::enable_if<std::is_arithmetic<that_value_type>::value>::type>
+    vecn operator / (const that_value_type& value) const
+    {
+        return vecn(simd::mul(lanes(), simd::splat(1.0f/static_cast<float>(value))));
+    }
+
+    // dot product
+    float operator * (const vecn& that) const
+    {
+        return prod(that);
+    }
+
+    float prod(const vecn& that) const
+    {
+        return simd::sum4(simd::mul(lanes(), that.lanes()));
+    }
+
+    float norm() const
+    {
+        return std::sqrt(prod(*this));
+    }
+
+    vecn abs() const
+    {
+        return vecn(simd::abs(lanes()));
+    }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + dims; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + dims; }
+    const_iterator cbegin() const { return _data; }
+    const_iterator cend() const { return _data + dims; }
+
+private:
+    alignas(16) float _data[4];
+};
+
+typedef vec3<float> vec3s;
+typedef vecn<float, 4> vec4s;
+
+// scalar on the left, the generic vectors get theirs from vec_expr.hpp
+template<class value_type, class = typename std::enable_if<std::is_arithmetic<value_type>::value>::type>
+inline vec3s operator * (const value_type& value, const vec3s& v)
+{
+    return v*value;
+}
+
+template<class value_type, class = typename std::enable_if<std::is_arithmetic<value_type>::value>::type>
+inline vec4s operator * (const value_type& value, const vec4s& v)
+{
+    return v*value;
+}
+
+} // end of cmn namespace
+
+#endif // VEC_SIMD_HPP
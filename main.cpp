@@ -1,13 +1,19 @@
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <string>
 
 #include <SDL2/SDL.h>
 
 #include "sdl/sdl.hpp"
 #include "geometry/geometry.hpp"
+#include "file_system/mesh_cache.hpp"
+#include "file_system/model_loader.hpp"
 #include "file_system/wavefront_obj.hpp"
 #include "model/model.hpp"
+#include "model/quantized_mesh.hpp"
 #include "software_render/software_render.hpp"
+#include "software_render/sdl_presenter.hpp"
 
 class test_context : public sdl_context
 {
@@ -17,32 +23,30 @@ public:
       , main_render(main_window)
       , screen_surface(main_window.surface())
       , screen_texture(main_render, screen_surface)
+      , presenter(screen_texture)
     {
-        std::ifstream mfile("../software_render/head.obj");
-        head_model = wavefront_obj::read_model(mfile);
+        head_model = mesh_cache::load("../software_render/head.obj");
     }
 
     void loop() override
     {
-        screen_texture.lockTexture();
+        const render::frame_view frame = presenter.lock();
 
-        render::line(cmn::vec2i(200, 300), cmn::vec2i(337, 387), screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
-        render::line(cmn::vec2i(225, 200), cmn::vec2i(190, 315), screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0xff, 0x00));
+        render::line(cmn::vec2i(200, 300), cmn::vec2i(337, 387), frame, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
+        render::line(cmn::vec2i(225, 200), cmn::vec2i(190, 315), frame, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0xff, 0x00));
 
 
-        render::line(cmn::vec2i(437, 487), cmn::vec2i(400, 400), screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0x00, 0x00));
-        render::line(cmn::vec2i(290, 415), cmn::vec2i(325, 300), screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0xff));
+        render::line(cmn::vec2i(437, 487), cmn::vec2i(400, 400), frame, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0x00, 0x00));
+        render::line(cmn::vec2i(290, 415), cmn::vec2i(325, 300), frame, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0xff));
 
         //std::array<Vec2i, 3> t0 = {Vec2i(10, 70),   Vec2i(50, 160),  Vec2i(70, 80)};
         //std::array<Vec2i, 3> t1 = {Vec2i(180, 50),  Vec2i(150, 1),   Vec2i(70, 180)};
         //std::array<Vec2i, 3> t2 = {Vec2i(180, 150), Vec2i(120, 160), Vec2i(130, 180)};
-        //render::triangle(t0, screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
-        //render::triangle(t1, screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0x00, 0xff));
-        //render::triangle(t2, screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0x00, 0x00));
+        //render::triangle(t0, frame, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
+        //render::triangle(t1, frame, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0x00, 0xff));
+        //render::triangle(t2, frame, SDL_MapRGB(screen_surface.pix_foramt(), 0xff, 0x00, 0x00));
 
-        screen_texture.unlockTexture();
-
-        screen_texture.render();
+        presenter.present();
     }
 
 private:
@@ -50,6 +54,7 @@ private:
     sdl_render main_render;
     sdl_surface_view screen_surface;
     sdl_texture screen_texture;
+    render::sdl_presenter presenter;
     model head_model;
 };
 
@@ -61,23 +66,43 @@ public:
       , main_render(main_window)
       , screen_surface(main_window.surface())
       , screen_texture(main_render, screen_surface)
+      , presenter(screen_texture)
+      , format(render::surface_format(screen_surface))
+      , target(screen_texture.width(), screen_texture.height())
+      , head_model("../software_render/head.obj")
     {
-        std::ifstream mfile("../software_render/head.obj");
-        head_model = wavefront_obj::read_model(mfile);
     }
 
     void loop() override
     {
-        screen_texture.lockTexture();
-        cmn::vec3f light_dir(0.00,0,-1);
-
-        render::surf(head_model, screen_texture, screen_surface, light_dir);
-
-        //render::mesh(head_model, screen_texture, SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
-
-        screen_texture.unlockTexture();
-
-        screen_texture.render();
+        // The camera orbits the model around y with the light at the eye.
+        const float orbit_step = 0.01f;
+        const float orbit_distance = 3.0f;
+        const float orbit_fovy = 0.7f;
+        orbit = (cmn::quaternion::from_axis_angle(cmn::vec3s(0.0f, 1.0f, 0.0f), orbit_step)*orbit).normalize();
+        const cmn::vec3s eye = orbit.rotate(cmn::vec3s(0.0f, 0.0f, orbit_distance));
+        const cmn::mat4 mvp = cmn::mat4::perspective(orbit_fovy, static_cast<float>(target.width())/target.height(), 0.1f, 10.0f)
+                              *cmn::mat4::look_at(eye, cmn::vec3s(), cmn::vec3s(0.0f, 1.0f, 0.0f));
+        const cmn::vec3s light = orbit.rotate(cmn::vec3s(0.0f, 0.0f, -1.0f));
+        cmn::vec3f light_dir(light.x(), light.y(), light.z());
+
+        target.clear();
+        if (head_model.ready())
+        {
+            head_model.get(); // rethrows a failed load
+        }
+        const std::shared_ptr<const model> shown = head_model.current();
+        if (!shown)
+        {
+            presenter.present(target);
+            return;
+        }
+        render::stats().reset();
+        render::surf(*shown, target, format, light_dir, culler, pipeline, mvp);
+
+        //render::mesh(*shown, target.view(), SDL_MapRGB(screen_surface.pix_foramt(), 0x00, 0xff, 0x00));
+
+        presenter.present(target);
     }
 
 private:
@@ -85,15 +110,81 @@ private:
     sdl_render main_render;
     sdl_surface_view screen_surface;
     sdl_texture screen_texture;
-    model head_model;
+    render::sdl_presenter presenter;
+    render::pixel_format format;
+    render::render_target target;
+    model_loader head_model;
+    render::face_culler culler;
+    render::tile_pipeline pipeline;
+    cmn::quaternion orbit;
 };
 
+// Renders frames into memory only, no window and no SDL initialization.
+template<class mesh_t>
+void headless(const mesh_t& head_model, int frames)
+{
+    render::render_target target(1024, 1024);
+    render::face_culler culler;
+    render::tile_pipeline pipeline;
+    const render::pixel_format format;
+    cmn::vec3f light_dir(0.00,0,-1);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        target.clear();
+        render::stats().reset();
+        render::surf(head_model, target, format, light_dir, culler, pipeline);
+    }
+    const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cout << "frames: " << frames << " avg = "
+              << std::chrono::duration<double, std::milli>(end - start).count()/std::max(frames, 1) << " ms" << std::endl;
+
+    // counters of the last frame
+    const render::cull_stats& culled = culler.stats();
+    std::cout << "faces: " << culled.faces
+              << " off screen = " << culled.off_screen
+              << " degenerate = " << culled.degenerate
+              << " back facing = " << culled.back_facing
+              << " visible = " << culled.visible << std::endl;
+    const render::vertex_stats& transformed = culler.vertexes().stats();
+    std::cout << "vertexes: transformed = " << transformed.transformed
+              << " face corners = " << transformed.corners << std::endl;
+    std::cout << "triangles: small = " << render::stats().small
+              << " pixels = " << render::stats().pixels
+              << " hierarchical = " << render::stats().hierarchical << std::endl;
+}
+
+void headless(int frames, bool quantized)
+{
+    mesh_cache::load_stats loaded;
+    const model head_model = mesh_cache::load("../software_render/head.obj", &loaded);
+    if (loaded.rebuilt)
+    {
+        std::cout << "cache rebuilt: ACMR " << loaded.acmr_before << " -> " << loaded.acmr_after << std::endl;
+    }
+    if (!quantized)
+    {
+        headless(head_model, frames);
+        return;
+    }
+    const quantized_mesh compact_model(head_model);
+    std::cout << "quantized: " << compact_model.bytes() << " bytes" << std::endl;
+    headless(compact_model, frames);
+}
+
 #include "geometry/vecN.hpp"
 
 int main(int argc, char *argv[])
 {
     try
     {
+        if (argc > 1 && std::string(argv[1]) == "--headless")
+        {
+            headless(argc > 2 ? std::stoi(argv[2]) : 100, argc > 3 && std::string(argv[3]) == "--quantized");
+            return 0;
+        }
+
         sdl_system sdl;
         render_context r;
         //test_context r;
@@ -0,0 +1,202 @@
+#include "face_order.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    std::vector<uint32_t> read_indexes(const index_buffer& indexes)
+    {
+        std::vector<uint32_t> result(indexes.size());
+        for (size_t i = 0; i < result.size(); ++i)
+        {
+            result[i] = indexes[i];
+        }
+        return result;
+    }
+
+    size_t vertexes_count(const std::vector<uint32_t>& indexes)
+    {
+        return indexes.empty() ? 0 : static_cast<size_t>(*std::max_element(indexes.begin(), indexes.end())) + 1;
+    }
+
+    void permute(index_buffer& indexes, const std::vector<uint32_t>& order)
+    {
+        if (indexes.empty())
+        {
+            return;
+        }
+        const std::vector<uint32_t> source = read_indexes(indexes);
+        uint32_t* target = indexes.wide_data();
+        for (size_t f = 0; f < order.size(); ++f)
+        {
+            std::copy(&source[3*order[f]], &source[3*order[f]] + 3, target + 3*f);
+        }
+        indexes.compact();
+    }
+
+    // Faces of every vertex in one flat array, offsets[v] to offsets[v + 1].
+    class adjacency
+    {
+    public:
+        adjacency(const std::vector<uint32_t>& indexes, size_t vertex_count) :
+            offsets(vertex_count + 1, 0)
+          , faces(indexes.size())
+        {
+            for (const uint32_t v: indexes)
+            {
+                ++offsets[v + 1];
+            }
+            for (size_t v = 0; v < vertex_count; ++v)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indexes.size(); ++i)
+            {
+                faces[fill[indexes[i]]++] = static_cast<uint32_t>(i/3);
+            }
+        }
+
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> faces;
+    };
+
+    // Cache state shared by the ACMR count and Tipsify: a vertex is cached
+    // while fewer than cache_size vertexes were transformed after it.
+    class fifo_cache
+    {
+    public:
+        fifo_cache(size_t vertex_count, size_t cache_size) :
+            time(cache_size + 1)
+          , size(cache_size)
+          , stamps(vertex_count, 0)
+        {}
+
+        bool cached(uint32_t v) const
+        {
+            return time - stamps[v] <= size;
+        }
+
+        // true on a miss
+        bool touch(uint32_t v)
+        {
+            if (cached(v))
+            {
+                return false;
+            }
+            stamps[v] = time++;
+            return true;
+        }
+
+        size_t time;
+        size_t size;
+        std::vector<size_t> stamps;
+    };
+}
+
+double face_order::acmr(const model& m, size_t cache_size)
+{
+    const std::vector<uint32_t> indexes = read_indexes(m.coord_indexes);
+    if (indexes.empty())
+    {
+        return 0.0;
+    }
+    fifo_cache cache(vertexes_count(indexes), cache_size);
+    size_t misses = 0;
+    for (const uint32_t v: indexes)
+    {
+        misses += cache.touch(v);
+    }
+    return static_cast<double>(misses)/(indexes.size()/3);
+}
+
+void face_order::optimize(model& m, size_t cache_size)
+{
+    const std::vector<uint32_t> indexes = read_indexes(m.coord_indexes);
+    const size_t face_count = indexes.size()/3;
+    const size_t vertex_count = vertexes_count(indexes);
+    if (face_count == 0)
+    {
+        return;
+    }
+    const adjacency faces_of(indexes, vertex_count);
+    std::vector<uint32_t> live(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v)
+    {
+        live[v] = faces_of.offsets[v + 1] - faces_of.offsets[v];
+    }
+    std::vector<bool> emitted(face_count, false);
+    std::vector<uint32_t> dead_end;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> order;
+    order.reserve(face_count);
+    fifo_cache cache(vertex_count, cache_size);
+    size_t cursor = 0;
+
+    int64_t fan = 0;
+    while (fan >= 0)
+    {
+        candidates.clear();
+        for (uint32_t i = faces_of.offsets[fan]; i < faces_of.offsets[fan + 1]; ++i)
+        {
+            const uint32_t face = faces_of.faces[i];
+            if (emitted[face])
+            {
+                continue;
+            }
+            emitted[face] = true;
+            order.push_back(face);
+            for (int k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indexes[3*face + k];
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                cache.touch(v);
+            }
+        }
+
+        // The next fan is the candidate that stays cached longest while its
+        // remaining faces are emitted, else the last dead end vertex with
+        // faces left, else the next such vertex in index order.
+        fan = -1;
+        size_t best = 0;
+        for (const uint32_t v: candidates)
+        {
+            if (live[v] == 0)
+            {
+                continue;
+            }
+            const size_t age = cache.time - cache.stamps[v];
+            const size_t priority = age + 2*live[v] <= cache_size ? age : 0;
+            if (fan < 0 || priority > best)
+            {
+                fan = v;
+                best = priority;
+            }
+        }
+        while (fan < 0 && !dead_end.empty())
+        {
+            const uint32_t v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0)
+            {
+                fan = v;
+            }
+        }
+        for (; fan < 0 && cursor < vertex_count; ++cursor)
+        {
+            if (live[cursor] > 0)
+            {
+                fan = static_cast<int64_t>(cursor);
+            }
+        }
+    }
+
+    permute(m.coord_indexes, order);
+    permute(m.texture_indexes, order);
+    permute(m.normal_indexes, order);
+    m.update_normals();
+}
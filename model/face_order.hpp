@@ -0,0 +1,30 @@
+#ifndef FACE_ORDER_HPP
+#define FACE_ORDER_HPP
+
+#include <cstddef>
+
+#include "model.hpp"
+
+// Face reordering for vertex reuse. The order comes from Tipsify (Sander,
+// Nehab, Barczak, "Fast triangle reordering for vertex locality and reduced
+// overdraw"): faces are emitted as fans around a vertex picked among the
+// ones still in a simulated FIFO cache, which also keeps consecutive faces
+// close to each other on screen.
+class face_order
+{
+public:
+    static const size_t default_cache_size = 32;
+
+    face_order() {}
+
+    // Average cache miss ratio, vertexes transformed per face through a FIFO
+    // cache of cache_size entries. 3 is the worst, about 0.5 the best on a
+    // closed mesh.
+    static double acmr(const model& m, size_t cache_size = default_cache_size);
+
+    // Permutes the faces of m, all index buffers alike, for cache_size,
+    // compacts the result and updates the normals.
+    static void optimize(model& m, size_t cache_size = default_cache_size);
+};
+
+#endif // FACE_ORDER_HPP
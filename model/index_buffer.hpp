@@ -0,0 +1,178 @@
+#ifndef INDEX_BUFFER_HPP
+#define INDEX_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "model_array.hpp"
+
+// Flat array of 0 based indexes. Built in 32 bits, compact() narrows it to
+// 16 bits when every index fits. no_index, a missing index, is all ones in
+// either width. Hot loops should take the typed array from data16/data32
+// once rather than go through operator[].
+class index_buffer
+{
+public:
+    static const uint32_t no_index = 0xffffffff;
+    static const uint16_t no_index16 = 0xffff;
+
+    index_buffer() :
+        _narrow(false)
+      , _revision(0)
+    {}
+
+    bool narrow() const
+    {
+        return _narrow;
+    }
+
+    size_t size() const
+    {
+        return _narrow ? _indexes16.size() : _indexes32.size();
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Revision of the indexes, see model_array::revision. Narrowing or
+    // widening the storage keeps it.
+    uint64_t revision() const
+    {
+        return _revision;
+    }
+
+    uint64_t stamp()
+    {
+        if (_revision == 0)
+        {
+            _revision = next_model_revision();
+        }
+        return _revision;
+    }
+
+    uint32_t operator[](size_t idx) const
+    {
+        if (_narrow)
+        {
+            const uint16_t value = _indexes16[idx];
+            return value == no_index16 ? no_index : value;
+        }
+        return _indexes32[idx];
+    }
+
+    // Typed storage for hot loops, nullptr unless the buffer has that width.
+    const uint16_t* data16() const
+    {
+        return _narrow ? _indexes16.data() : nullptr;
+    }
+
+    const uint32_t* data32() const
+    {
+        return _narrow ? nullptr : _indexes32.data();
+    }
+
+    void push_back(uint32_t idx)
+    {
+        widen();
+        _indexes32.push_back(idx);
+        _revision = 0;
+    }
+
+    void resize(size_t size)
+    {
+        widen();
+        _indexes32.resize(size);
+        _revision = 0;
+    }
+
+    void clear()
+    {
+        _indexes16.clear();
+        _indexes32.clear();
+        _narrow = false;
+        _revision = 0;
+    }
+
+    // 32 bit storage, for filling in place
+    uint32_t* wide_data()
+    {
+        widen();
+        _revision = 0;
+        return _indexes32.data();
+    }
+
+    void compact()
+    {
+        if (_narrow)
+        {
+            return;
+        }
+        const model_array<uint32_t>& wide = _indexes32;
+        const uint32_t* begin = wide.begin();
+        const uint32_t* end = wide.end();
+        if (std::any_of(begin, end, [](uint32_t idx) { return idx >= no_index16 && idx != no_index; }))
+        {
+            return;
+        }
+        _indexes16.resize(_indexes32.size());
+        std::transform(begin, end, _indexes16.begin(), [](uint32_t idx)
+        {
+            return static_cast<uint16_t>(idx);
+        });
+        _indexes32.clear();
+        _narrow = true;
+    }
+
+    // Raw bytes and element size of the storage in use, for the mesh cache.
+    const void* data() const
+    {
+        return _narrow ? static_cast<const void*>(_indexes16.data()) : static_cast<const void*>(_indexes32.data());
+    }
+
+    size_t element_size() const
+    {
+        return _narrow ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    void borrow(const void* data, size_t size, size_t element_size, std::shared_ptr<const void> owner)
+    {
+        clear();
+        _narrow = element_size == sizeof(uint16_t);
+        if (_narrow)
+        {
+            _indexes16.borrow(static_cast<const uint16_t*>(data), size, std::move(owner));
+        }
+        else
+        {
+            _indexes32.borrow(static_cast<const uint32_t*>(data), size, std::move(owner));
+        }
+    }
+
+private:
+    void widen()
+    {
+        if (!_narrow)
+        {
+            return;
+        }
+        const model_array<uint16_t>& indexes16 = _indexes16;
+        _indexes32.resize(indexes16.size());
+        std::transform(indexes16.begin(), indexes16.end(), _indexes32.begin(), [](uint16_t idx)
+        {
+            return idx == no_index16 ? no_index : static_cast<uint32_t>(idx);
+        });
+        _indexes16.clear();
+        _narrow = false;
+    }
+
+    model_array<uint16_t> _indexes16;
+    model_array<uint32_t> _indexes32;
+    bool _narrow;
+    uint64_t _revision;
+};
+
+#endif // INDEX_BUFFER_HPP
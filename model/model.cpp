@@ -1,5 +1,235 @@
 #include "model.hpp"
 
-model::model()
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    class corner
+    {
+    public:
+        bool operator==(const corner& that) const
+        {
+            return coord == that.coord && texture == that.texture && normal == that.normal;
+        }
+
+        uint32_t coord;
+        uint32_t texture;
+        uint32_t normal;
+    };
+
+    class corner_hash
+    {
+    public:
+        size_t operator()(const corner& key) const
+        {
+            uint64_t value = key.coord;
+            value = value*0x9e3779b97f4a7c15ull ^ key.texture;
+            value = value*0x9e3779b97f4a7c15ull ^ key.normal;
+            return static_cast<size_t>(value ^ (value >> 32));
+        }
+    };
+
+    // Attribute of a welded vertex, zero where the corner had none.
+    point3d attribute(const model_array<point3d>& values, uint32_t idx)
+    {
+        return idx < values.size() ? values[idx] : point3d();
+    }
+}
+
+model::model() :
+    _vertexes_revision(0)
+  , _indexes_revision(0)
+{
+}
+
+size_t model::faces_count() const
+{
+    return coord_indexes.size()/3;
+}
+
+model::face_t model::face(size_t idx) const
+{
+    face_t tmp;
+    for (int i = 0; i < 3; ++i)
+    {
+        tmp.coords[i] = coord_indexes[3*idx + i];
+        if (welded())
+        {
+            tmp.texture[i] = texture_vertexes.empty() ? index_buffer::no_index : tmp.coords[i];
+            tmp.normals[i] = normals.empty() ? index_buffer::no_index : tmp.coords[i];
+        }
+        else
+        {
+            tmp.texture[i] = texture_indexes[3*idx + i];
+            tmp.normals[i] = normal_indexes[3*idx + i];
+        }
+    }
+    return tmp;
+}
+
+void model::add_face(const face_t& face)
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        coord_indexes.push_back(face.coords[i]);
+        texture_indexes.push_back(face.texture[i]);
+        normal_indexes.push_back(face.normals[i]);
+    }
+}
+
+void model::compact()
+{
+    coord_indexes.compact();
+    texture_indexes.compact();
+    normal_indexes.compact();
+}
+
+bool model::face_in_range(size_t idx) const
+{
+    const size_t vertex_count = vertexes.size();
+    return coord_indexes[3*idx] < vertex_count && coord_indexes[3*idx + 1] < vertex_count
+        && coord_indexes[3*idx + 2] < vertex_count;
+}
+
+void model::drop_invalid_faces()
+{
+    const size_t face_count = faces_count();
+    size_t kept = 0;
+    while (kept < face_count && face_in_range(kept))
+    {
+        ++kept;
+    }
+    if (kept == face_count)
+    {
+        return; // nothing to drop, the buffers stay untouched
+    }
+    index_buffer* buffers[] = {&coord_indexes, &texture_indexes, &normal_indexes};
+    for (size_t f = kept + 1; f < face_count; ++f)
+    {
+        if (!face_in_range(f))
+        {
+            continue;
+        }
+        for (index_buffer* buffer: buffers)
+        {
+            if (!buffer->empty())
+            {
+                uint32_t* indexes = buffer->wide_data();
+                std::copy(indexes + 3*f, indexes + 3*f + 3, indexes + 3*kept);
+            }
+        }
+        ++kept;
+    }
+    for (index_buffer* buffer: buffers)
+    {
+        if (!buffer->empty())
+        {
+            buffer->resize(3*kept);
+        }
+    }
+}
+
+void model::weld()
+{
+    if (welded())
+    {
+        return;
+    }
+    const size_t face_count = faces_count();
+    const bool has_texture = !texture_vertexes.empty();
+    const bool has_normals = !normals.empty();
+    std::unordered_map<corner, uint32_t, corner_hash> unique;
+    unique.reserve(vertexes.size() + vertexes.size()/2);
+
+    model welded_model;
+    welded_model.coord_indexes.resize(3*face_count);
+    uint32_t* indexes = welded_model.coord_indexes.wide_data();
+    size_t kept = 0;
+    for (size_t f = 0; f < face_count; ++f)
+    {
+        if (!face_in_range(f))
+        {
+            continue;
+        }
+        for (size_t i = 3*f; i < 3*f + 3; ++i)
+        {
+            corner key;
+            key.coord = coord_indexes[i];
+            key.texture = has_texture ? texture_indexes[i] : index_buffer::no_index;
+            key.normal = has_normals ? normal_indexes[i] : index_buffer::no_index;
+            const auto inserted = unique.insert(std::make_pair(key, static_cast<uint32_t>(welded_model.vertexes.size())));
+            if (inserted.second)
+            {
+                welded_model.vertexes.push_back(attribute(vertexes, key.coord));
+                if (has_texture)
+                {
+                    welded_model.texture_vertexes.push_back(attribute(texture_vertexes, key.texture));
+                }
+                if (has_normals)
+                {
+                    welded_model.normals.push_back(attribute(normals, key.normal));
+                }
+            }
+            indexes[kept++] = inserted.first->second;
+        }
+    }
+    welded_model.coord_indexes.resize(kept);
+    welded_model.compact();
+    welded_model.update_normals();
+    *this = std::move(welded_model);
+}
+
+bool model::welded() const
+{
+    return texture_indexes.empty() && normal_indexes.empty() && !coord_indexes.empty();
+}
+
+void model::update_normals()
+{
+    const size_t face_count = faces_count();
+    const size_t vertex_count = vertexes.size();
+    face_normals.resize(face_count);
+    vertex_normals.resize(vertex_count);
+    position_streams.resize(vertex_count);
+    const model_array<point3d>& positions = vertexes; // const reads keep a borrowed array borrowed
+    for (size_t v = 0; v < vertex_count; ++v)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            position_streams.set(c, v, static_cast<float>(positions[v][c]));
+        }
+    }
+    std::vector<point3d> sums(vertex_count);
+    for (size_t f = 0; f < face_count; ++f)
+    {
+        if (!face_in_range(f))
+        {
+            face_normals.set(f, point3d());
+            continue;
+        }
+        const uint32_t a = coord_indexes[3*f];
+        const uint32_t b = coord_indexes[3*f + 1];
+        const uint32_t c = coord_indexes[3*f + 2];
+        // twice the face area long, so the vertex sums are area weighted
+        const point3d n = (positions[b]-positions[a]).vec_prod(positions[c]-positions[a]);
+        face_normals.set(f, n.normalize());
+        sums[a] += n;
+        sums[b] += n;
+        sums[c] += n;
+    }
+    for (size_t v = 0; v < vertex_count; ++v)
+    {
+        const double length = sums[v].norm();
+        vertex_normals.set(v, length > 0.0 ? sums[v]/length : point3d());
+    }
+    _vertexes_revision = vertexes.stamp();
+    _indexes_revision = coord_indexes.stamp();
+}
+
+bool model::normals_updated() const
 {
+    return _vertexes_revision != 0 && vertexes.revision() == _vertexes_revision
+        && coord_indexes.revision() == _indexes_revision;
 }
@@ -1,27 +1,93 @@
 #ifndef MODEL_HPP
 #define MODEL_HPP
 
-#include <vector>
+#include <cstddef>
+#include <cstdint>
 
 #include "geometry/geometry.hpp"
 
+#include "index_buffer.hpp"
+#include "model_array.hpp"
+#include "vec3_streams.hpp"
+
 class model
 {
 public:
+    // Indexes of one face's corners, index_buffer::no_index where the file
+    // gave none.
     class face_t
     {
     public:
-        point3d coords;
-        point3d texture;
-        point3d normals;
+        uint32_t coords[3];
+        uint32_t texture[3];
+        uint32_t normals[3];
     };
 
     model();
 
-    std::vector<point3d> vertexes;
-    std::vector<point3d> texture_vertexes;
-    std::vector<point3d> normals;
-    std::vector<face_t> faces;
+    size_t faces_count() const;
+
+    face_t face(size_t idx) const;
+
+    void add_face(const face_t& face);
+
+    // Narrows the index buffers that fit in 16 bits, call once loading is done.
+    void compact();
+
+    // True when the three coord indexes of face idx are within vertexes.
+    bool face_in_range(size_t idx) const;
+
+    // Removes the faces that aren't in range, out of range or missing
+    // indexes in the file, from every index buffer. Loading calls it once
+    // the indexes are final.
+    void drop_invalid_faces();
+
+    // Replaces every distinct (coord, texture, normal) corner with one vertex
+    // so the attribute arrays run in parallel and coord_indexes is the only
+    // index buffer. A corner without a texture or normal index gets a zero
+    // one when the other corners have them. Faces that aren't in range are
+    // dropped. Compacts the result.
+    void weld();
+
+    // True once the texture and normal arrays are indexed by coord_indexes.
+    bool welded() const;
+
+    // Recomputes face_normals, vertex_normals and position_streams from
+    // vertexes and coord_indexes. Loading, weld() and face_order::optimize()
+    // call it, anything else that changes vertexes or faces has to call it
+    // again. Faces that aren't in range get a zero normal and add nothing to
+    // the vertex normals.
+    void update_normals();
+
+    // False once vertexes or coord_indexes had any non const access since
+    // the last update_normals(), the derived data may be stale then.
+    bool normals_updated() const;
+
+    model_array<point3d> vertexes;
+    model_array<point3d> texture_vertexes;
+    model_array<point3d> normals;
+
+    // Three per face, one buffer per attribute so the renderer, which only
+    // needs positions, reads nothing else. Welded models leave the texture
+    // and normal buffers empty.
+    index_buffer coord_indexes;
+    index_buffer texture_indexes;
+    index_buffer normal_indexes;
+
+    // Unit outward normal of every face, counter clockwise winding, and the
+    // area weighted unit normal of every vertex. Unlike normals, which holds
+    // the vn lines of the file, these always exist.
+    vec3_streams face_normals;
+    vec3_streams vertex_normals;
+
+    // vertexes in single precision, one padded simd array per coordinate,
+    // for the batch kernels of the vertex stage
+    cmn::soa3 position_streams;
+
+private:
+    // revisions of vertexes and coord_indexes the derived data was computed from
+    uint64_t _vertexes_revision;
+    uint64_t _indexes_revision;
 };
 
 #endif // MODEL_HPP
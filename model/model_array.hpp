@@ -0,0 +1,222 @@
+#ifndef MODEL_ARRAY_HPP
+#define MODEL_ARRAY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Revisions of model_array and index_buffer contents. 0 means changed since
+// the last stamp, other values are unique in the process, so two arrays with
+// the same non zero revision hold the same data.
+inline uint64_t next_model_revision()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+// Array of model data that either owns its elements or borrows them from
+// read only memory, a mapped cache file, that it keeps alive. Reads look the
+// same either way. Any non const access to a borrowed array copies it into
+// owned storage first, so the renderer should only see const models.
+template<class value_t>
+class model_array
+{
+public:
+    typedef value_t value_type;
+    typedef value_t* iterator;
+    typedef const value_t* const_iterator;
+
+    model_array() :
+        _data(nullptr)
+      , _size(0)
+      , _revision(0)
+    {}
+
+    model_array(const model_array& that) :
+        _owned(that._owned)
+      , _keep_alive(that._keep_alive)
+      , _data(that._data)
+      , _size(that._size)
+      , _revision(that._revision)
+    {
+        sync();
+    }
+
+    model_array(model_array&& that) :
+        _owned(std::move(that._owned))
+      , _keep_alive(std::move(that._keep_alive))
+      , _data(that._data)
+      , _size(that._size)
+      , _revision(that._revision)
+    {
+        that.reset();
+    }
+
+    model_array& operator=(model_array that)
+    {
+        swap(that);
+        return *this;
+    }
+
+    void swap(model_array& that)
+    {
+        _owned.swap(that._owned);
+        _keep_alive.swap(that._keep_alive);
+        std::swap(_data, that._data);
+        std::swap(_size, that._size);
+        std::swap(_revision, that._revision);
+    }
+
+    // Points the array at size elements of data, owner keeps them valid.
+    void borrow(const value_t* data, size_t size, std::shared_ptr<const void> owner)
+    {
+        _owned.clear();
+        _owned.shrink_to_fit();
+        _keep_alive = std::move(owner);
+        _data = data;
+        _size = size;
+        _revision = 0;
+    }
+
+    bool borrowed() const
+    {
+        return static_cast<bool>(_keep_alive);
+    }
+
+    // Revision of the contents, 0 after any non const access.
+    uint64_t revision() const
+    {
+        return _revision;
+    }
+
+    // Gives changed contents a new revision and returns it.
+    uint64_t stamp()
+    {
+        if (_revision == 0)
+        {
+            _revision = next_model_revision();
+        }
+        return _revision;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    const value_t* data() const
+    {
+        return _data;
+    }
+
+    const value_t& operator[](size_t idx) const
+    {
+        return _data[idx];
+    }
+
+    const_iterator begin() const
+    {
+        return _data;
+    }
+
+    const_iterator end() const
+    {
+        return _data + _size;
+    }
+
+    value_t* data()
+    {
+        own();
+        _revision = 0;
+        return _owned.data();
+    }
+
+    value_t& operator[](size_t idx)
+    {
+        own();
+        _revision = 0;
+        return _owned[idx];
+    }
+
+    iterator begin()
+    {
+        return data();
+    }
+
+    iterator end()
+    {
+        return data() + _size;
+    }
+
+    void reserve(size_t size)
+    {
+        own();
+        _owned.reserve(size);
+        sync();
+    }
+
+    void resize(size_t size)
+    {
+        own();
+        _owned.resize(size);
+        _revision = 0;
+        sync();
+    }
+
+    void clear()
+    {
+        reset();
+    }
+
+    void push_back(const value_t& value)
+    {
+        own();
+        _owned.push_back(value);
+        _revision = 0;
+        sync();
+    }
+
+private:
+    void own()
+    {
+        if (_keep_alive)
+        {
+            _owned.assign(_data, _data + _size);
+            _keep_alive.reset();
+            sync();
+        }
+    }
+
+    void sync()
+    {
+        if (!_keep_alive)
+        {
+            _data = _owned.data();
+            _size = _owned.size();
+        }
+    }
+
+    void reset()
+    {
+        _owned.clear();
+        _keep_alive.reset();
+        _revision = 0;
+        sync();
+    }
+
+    std::vector<value_t> _owned;
+    std::shared_ptr<const void> _keep_alive;
+    const value_t* _data;
+    size_t _size;
+    uint64_t _revision;
+};
+
+#endif // MODEL_ARRAY_HPP
@@ -0,0 +1,122 @@
+#include "quantized_mesh.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const double unorm16_max = 65535.;
+    const double snorm16_max = 32767.;
+
+    uint16_t unorm16(double value, double origin, double step)
+    {
+        const double q = step > 0. ? (value - origin)/step : 0.;
+        return static_cast<uint16_t>(std::min(std::max(q + 0.5, 0.), unorm16_max));
+    }
+
+    uint16_t snorm16(double value)
+    {
+        const double q = std::min(std::max(value, -1.), 1.)*snorm16_max;
+        return static_cast<uint16_t>(static_cast<int16_t>(q < 0. ? q - 0.5 : q + 0.5));
+    }
+
+    // Lower corner and the size of one of 65535 steps per axis.
+    void bounds(const model_array<point3d>& values, size_t dims, point3d& origin, point3d& step)
+    {
+        point3d low(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+        point3d high(-low.x(), -low.y(), -low.z());
+        for (const point3d& v: values)
+        {
+            for (size_t d = 0; d < dims; ++d)
+            {
+                low[d] = std::min(low[d], v[d]);
+                high[d] = std::max(high[d], v[d]);
+            }
+        }
+        origin = point3d();
+        step = point3d();
+        for (size_t d = 0; d < dims && !values.empty(); ++d)
+        {
+            origin[d] = low[d];
+            step[d] = (high[d] - low[d])/unorm16_max;
+        }
+    }
+}
+
+quantized_mesh::quantized_mesh(const model& m)
+{
+    if (m.welded() && m.normals_updated())
+    {
+        build(m);
+        return;
+    }
+    // not recursive, a model without faces is still unwelded after weld()
+    model welded_model = m;
+    welded_model.weld();
+    welded_model.update_normals();
+    build(welded_model);
+}
+
+void quantized_mesh::build(const model& m)
+{
+    const size_t vertex_count = m.vertexes.size();
+    bounds(m.vertexes, 3, origin, step);
+    positions.resize(vertex_count);
+    vertex_normals.resize(vertex_count);
+    for (size_t i = 0; i < vertex_count; ++i)
+    {
+        const point3d& v = m.vertexes[i];
+        position_t& p = positions[i];
+        p.x = unorm16(v.x(), origin.x(), step.x());
+        p.y = unorm16(v.y(), origin.y(), step.y());
+        p.z = unorm16(v.z(), origin.z(), step.z());
+        vertex_normals[i] = encode_normal(m.vertex_normals.get(i));
+    }
+
+    if (!m.texture_vertexes.empty())
+    {
+        point3d uv_low, uv_size;
+        bounds(m.texture_vertexes, 2, uv_low, uv_size);
+        uv_origin = point2d(uv_low.x(), uv_low.y());
+        uv_step = point2d(uv_size.x(), uv_size.y());
+        uvs.resize(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            const point3d& uv = m.texture_vertexes[i];
+            uvs[i] = unorm16(uv.x(), uv_origin.x(), uv_step.x()) | static_cast<uint32_t>(unorm16(uv.y(), uv_origin.y(), uv_step.y())) << 16;
+        }
+    }
+
+    const size_t face_count = m.faces_count();
+    face_normals.resize(face_count);
+    for (size_t f = 0; f < face_count; ++f)
+    {
+        face_normals[f] = encode_normal(m.face_normals.get(f));
+    }
+    coord_indexes = m.coord_indexes;
+}
+
+size_t quantized_mesh::bytes() const
+{
+    return positions.size()*sizeof(position_t)
+        + (uvs.size() + vertex_normals.size() + face_normals.size())*sizeof(uint32_t)
+        + coord_indexes.size()*coord_indexes.element_size();
+}
+
+uint32_t quantized_mesh::encode_normal(const point3d& n)
+{
+    const double l1 = std::fabs(n.x()) + std::fabs(n.y()) + std::fabs(n.z());
+    if (l1 == 0.)
+    {
+        return 0;
+    }
+    double x = n.x()/l1;
+    double y = n.y()/l1;
+    if (n.z() < 0.)
+    {
+        const double folded_x = (1. - std::fabs(y))*(x < 0. ? -1. : 1.);
+        y = (1. - std::fabs(x))*(y < 0. ? -1. : 1.);
+        x = folded_x;
+    }
+    return snorm16(x) | static_cast<uint32_t>(snorm16(y)) << 16;
+}
@@ -0,0 +1,110 @@
+#ifndef QUANTIZED_MESH_HPP
+#define QUANTIZED_MESH_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "geometry/geometry.hpp"
+
+#include "index_buffer.hpp"
+#include "model.hpp"
+#include "model_array.hpp"
+
+// Compact copy of a welded model for drawing. Positions are 16 bit fixed
+// point across the model's bounding box, texture coordinates 16 bit fixed
+// point across their own bounds, and vertex and face normals octahedral
+// encoded in two 16 bit snorms. A vertex takes 14 bytes instead of 72 and a
+// face normal 4 instead of 24. Values are decoded where they are read, the
+// vertex cache decodes positions in its transform loop.
+class quantized_mesh
+{
+public:
+    class position_t
+    {
+    public:
+        uint16_t x;
+        uint16_t y;
+        uint16_t z;
+    };
+
+    quantized_mesh() {}
+
+    // Welds a copy of m first when it isn't welded.
+    explicit quantized_mesh(const model& m);
+
+    size_t vertexes_count() const
+    {
+        return positions.size();
+    }
+
+    size_t faces_count() const
+    {
+        return coord_indexes.size()/3;
+    }
+
+    point3d position(size_t idx) const
+    {
+        const position_t& p = positions[idx];
+        return point3d(origin.x() + p.x*step.x(), origin.y() + p.y*step.y(), origin.z() + p.z*step.z());
+    }
+
+    // zero when the model had no texture coordinates
+    point2d texture_coords(size_t idx) const
+    {
+        if (uvs.empty())
+        {
+            return point2d();
+        }
+        const uint32_t uv = uvs[idx];
+        return point2d(uv_origin.x() + (uv & 0xffff)*uv_step.x(), uv_origin.y() + (uv >> 16)*uv_step.y());
+    }
+
+    point3d vertex_normal(size_t idx) const
+    {
+        return decode_normal(vertex_normals[idx]);
+    }
+
+    point3d face_normal(size_t idx) const
+    {
+        return decode_normal(face_normals[idx]);
+    }
+
+    // Bytes of vertex, face and index data.
+    size_t bytes() const;
+
+    // Octahedral mapping of a unit vector to two 16 bit snorms, x in the
+    // low half. A zero vector decodes to +z.
+    static uint32_t encode_normal(const point3d& n);
+
+    static point3d decode_normal(uint32_t packed)
+    {
+        double x = static_cast<int16_t>(packed & 0xffff)/32767.;
+        double y = static_cast<int16_t>(packed >> 16)/32767.;
+        const double z = 1. - std::fabs(x) - std::fabs(y);
+        if (z < 0.)
+        {
+            const double folded_x = (1. - std::fabs(y))*(x < 0. ? -1. : 1.);
+            y = (1. - std::fabs(x))*(y < 0. ? -1. : 1.);
+            x = folded_x;
+        }
+        return point3d(x, y, z).normalize();
+    }
+
+    point3d origin;
+    point3d step;
+    point2d uv_origin;
+    point2d uv_step;
+
+    model_array<position_t> positions;
+    model_array<uint32_t> uvs;
+    model_array<uint32_t> vertex_normals;
+    model_array<uint32_t> face_normals;
+    index_buffer coord_indexes;
+
+private:
+    // m has to be welded with its normals updated
+    void build(const model& m);
+};
+
+#endif // QUANTIZED_MESH_HPP
@@ -0,0 +1,56 @@
+#ifndef VEC3_STREAMS_HPP
+#define VEC3_STREAMS_HPP
+
+#include <cstddef>
+
+#include "geometry/geometry.hpp"
+
+#include "model_array.hpp"
+
+// Array of three component vectors stored as one array per component, so a
+// loop over one component reads contiguous memory.
+class vec3_streams
+{
+public:
+    size_t size() const
+    {
+        return x.size();
+    }
+
+    bool empty() const
+    {
+        return x.empty();
+    }
+
+    void resize(size_t size)
+    {
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+    }
+
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+
+    point3d get(size_t idx) const
+    {
+        return point3d(x[idx], y[idx], z[idx]);
+    }
+
+    void set(size_t idx, const point3d& value)
+    {
+        x[idx] = value.x();
+        y[idx] = value.y();
+        z[idx] = value.z();
+    }
+
+    model_array<double> x;
+    model_array<double> y;
+    model_array<double> z;
+};
+
+#endif // VEC3_STREAMS_HPP
@@ -0,0 +1,140 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel
+{
+
+// Persistent worker threads for data parallel loops. The calling thread takes
+// part in every loop, so a pool of N threads keeps N + 1 cores busy.
+class thread_pool
+{
+public:
+    typedef std::function<void(size_t)> job_type;
+
+    explicit thread_pool(unsigned threads = default_size()) :
+        _job(nullptr)
+      , _count(0)
+      , _next(0)
+      , _busy(0)
+      , _generation(0)
+      , _stop(false)
+    {
+        for (unsigned i = 0; i < threads; ++i)
+        {
+            _threads.emplace_back(&thread_pool::worker, this);
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& thread: _threads)
+        {
+            thread.join();
+        }
+    }
+
+    static unsigned default_size()
+    {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    unsigned size() const
+    {
+        return static_cast<unsigned>(_threads.size());
+    }
+
+    // Calls job(i) for every i in [0, count) and returns when all calls are done.
+    // Indexes are handed out one at a time, so uneven jobs balance themselves.
+    void parallel_for(size_t count, const job_type& job)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _job = &job;
+            _count = count;
+            _next = 0;
+            _busy = _threads.size();
+            ++_generation;
+        }
+        _wake.notify_all();
+
+        run(job, count);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done.wait(lock, [this]() { return _busy == 0; });
+        _job = nullptr;
+    }
+
+private:
+    void run(const job_type& job, size_t count)
+    {
+        for (size_t i = _next++; i < count; i = _next++)
+        {
+            job(i);
+        }
+    }
+
+    void worker()
+    {
+        uint64_t seen = 0;
+        for (;;)
+        {
+            const job_type* job = nullptr;
+            size_t count = 0;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [this, &seen]() { return _stop || _generation != seen; });
+                if (_stop)
+                {
+                    return;
+                }
+                seen = _generation;
+                job = _job;
+                count = _count;
+            }
+
+            run(*job, count);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0)
+            {
+                _done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const job_type* _job;
+    size_t _count;
+    std::atomic<size_t> _next;
+    size_t _busy;
+    uint64_t _generation;
+    bool _stop;
+};
+
+} // end of namespace parallel
+
+#endif // THREAD_POOL_HPP
@@ -13,7 +13,7 @@ using hrc = high_resolution_clock;
 
 sdl_system::sdl_system()
 {
-    if( SDL_Init(SDL_INIT_EVERYTHING) < 0 )
+    if( SDL_Init(SDL_INIT_VIDEO) < 0 )
     {
         throw sdl_exception("SDL could not initialize!");
     }
@@ -96,7 +96,7 @@ int sdl_texture::pitch()
 
 uint32_t& sdl_texture::at(int x, int y)
 {
-    return *(reinterpret_cast<uint32_t*>(((uint8_t*)_pixels) + (_height - y)*_pitch + x*sizeof(uint32_t)));
+    return *(reinterpret_cast<uint32_t*>(((uint8_t*)_pixels) + (_height - 1 - y)*_pitch + x*sizeof(uint32_t)));
 }
 
 void sdl_texture::render()
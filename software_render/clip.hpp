@@ -0,0 +1,140 @@
+#ifndef CLIP_HPP
+#define CLIP_HPP
+
+#include <array>
+
+#include "geometry/geometry.hpp"
+
+namespace render
+{
+
+namespace clip
+{
+    // Half size of the guard band in NDC, 1.0 is the viewport itself. Inside
+    // it triangles are only scissored by the rasterizer, beyond it they are
+    // cut so the fixed point setup never sees runaway coordinates.
+    const double guard_band = 4.0;
+
+    enum plane
+    {
+        plane_near
+        ,plane_left
+        ,plane_right
+        ,plane_bottom
+        ,plane_top
+        ,planes_count
+    };
+
+    // Model space to clip space for the fixed camera looking down -z at the
+    // unit cube, so the clip space depth is -z and smaller is closer. Any
+    // other camera is a view and projection matrix with the same depth
+    // convention, mat4::look_at and mat4::perspective give one.
+    inline cmn::mat4 fixed_camera()
+    {
+        return cmn::mat4::orthographic(-1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f);
+    }
+
+    // Signed distance to the plane in homogeneous space, inside when >= 0.
+    inline double distance(const point4d& v, int p, double extent)
+    {
+        switch (p)
+        {
+        case plane_near:   return v[2] + v[3];
+        case plane_left:   return extent*v[3] + v[0];
+        case plane_right:  return extent*v[3] - v[0];
+        case plane_bottom: return extent*v[3] + v[1];
+        default:           return extent*v[3] - v[1];
+        }
+    }
+
+    inline int outcode(const point4d& v, double extent)
+    {
+        int code = 0;
+        for (int p = 0; p < planes_count; ++p)
+        {
+            code |= (distance(v, p, extent) < 0.0) << p;
+        }
+        return code;
+    }
+
+    inline point3d to_screen(const point4d& v, int width, int height)
+    {
+        const double w = 1.0/v[3];
+        return point3d((v[0]*w + 1.)*width/2., (v[1]*w + 1.)*height/2., v[2]*w);
+    }
+}
+
+// Clips a clip space triangle (x, y, z in [-w, w] is visible) against the near
+// plane and the guard band, then projects it and hands the screen triangles,
+// with z/w as depth, to emit. Triangles entirely outside one viewport plane or
+// behind the near plane are dropped, triangles inside the guard band pass
+// through uncut.
+template<class emit_t>
+inline void clip_triangle(const triangle4d& vertexes, int width, int height, emit_t emit)
+{
+    int viewport_or = 0, viewport_and = ~0, guard_or = 0;
+    for (const point4d& v: vertexes)
+    {
+        const int viewport_code = clip::outcode(v, 1.0);
+        viewport_or |= viewport_code;
+        viewport_and &= viewport_code;
+        guard_or |= clip::outcode(v, clip::guard_band);
+    }
+    if (viewport_and != 0)
+    {
+        return;
+    }
+    if (guard_or == 0)
+    {
+        emit(triangle3d{{clip::to_screen(vertexes[0], width, height)
+                         , clip::to_screen(vertexes[1], width, height)
+                         , clip::to_screen(vertexes[2], width, height)}});
+        return;
+    }
+
+    // Sutherland-Hodgman against the planes actually crossed, a triangle
+    // gains at most one vertex per plane.
+    std::array<point4d, 3 + clip::planes_count> polygons[2];
+    int count = 3;
+    std::copy(vertexes.begin(), vertexes.end(), polygons[0].begin());
+    int current = 0;
+    for (int p = 0; p < clip::planes_count && count >= 3; ++p)
+    {
+        if (!(guard_or & (1 << p)))
+        {
+            continue;
+        }
+        const auto& in = polygons[current];
+        auto& out = polygons[current ^ 1];
+        int out_count = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            const point4d& a = in[i];
+            const point4d& b = in[(i + 1)%count];
+            const double da = clip::distance(a, p, clip::guard_band);
+            const double db = clip::distance(b, p, clip::guard_band);
+            if (da >= 0.0)
+            {
+                out[out_count++] = a;
+            }
+            if ((da >= 0.0) != (db >= 0.0))
+            {
+                out[out_count++] = a + (b - a)*(da/(da - db));
+            }
+        }
+        count = out_count;
+        current ^= 1;
+    }
+
+    const auto& polygon = polygons[current];
+    for (int i = 1; i + 1 < count; ++i)
+    {
+        emit(triangle3d{{clip::to_screen(polygon[0], width, height)
+                         , clip::to_screen(polygon[i], width, height)
+                         , clip::to_screen(polygon[i + 1], width, height)}});
+    }
+}
+
+} // end of namespace render
+
+#endif // CLIP_HPP
@@ -0,0 +1,157 @@
+#ifndef CULL_HPP
+#define CULL_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+#include "model/model.hpp"
+
+#include "clip.hpp"
+#include "raster.hpp"
+#include "vertex_cache.hpp"
+
+namespace render
+{
+
+// Faces removed by each test of the last face_culler::run. The tests are
+// applied in the order of the members, a face is counted by the first one
+// that removes it.
+class cull_stats
+{
+public:
+    cull_stats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        faces = 0;
+        off_screen = 0;
+        degenerate = 0;
+        back_facing = 0;
+        visible = 0;
+    }
+
+    uint64_t faces;
+    uint64_t off_screen;
+    uint64_t degenerate;
+    uint64_t back_facing;
+    uint64_t visible;
+};
+
+// Culling prepass over the whole face array. Vertexes go through the vertex
+// cache once, then every face gets a verdict from its screen space signed
+// area and the outcodes of its corners without branching, and the survivors
+// are compacted into a list of face indexes for shading and rasterization.
+// Faces with a corner behind the camera skip the area tests, their projected
+// winding means nothing and the clipper deals with them.
+class face_culler
+{
+public:
+    // doubled screen area below which a face snaps to nothing in 24.8
+    static constexpr float min_area = 1.0f/(subpixel::one*subpixel::one);
+
+    // mesh_t is a model or a quantized_mesh
+    template<class mesh_t>
+    void run(const mesh_t& m, int width, int height)
+    {
+        run(m, clip::fixed_camera(), width, height);
+    }
+
+    template<class mesh_t>
+    void run(const mesh_t& m, const cmn::mat4& mvp, int width, int height)
+    {
+        _vertexes.run(m, mvp, width, height);
+
+        const size_t face_count = m.faces_count();
+        _verdicts.resize(face_count);
+        if (m.coord_indexes.narrow())
+        {
+            classify(m.coord_indexes.data16(), face_count);
+        }
+        else
+        {
+            classify(m.coord_indexes.data32(), face_count);
+        }
+
+        _visible.clear();
+        uint64_t counts[verdicts_count] = {};
+        for (size_t f = 0; f < face_count; ++f)
+        {
+            ++counts[_verdicts[f]];
+            if (_verdicts[f] == verdict_visible)
+            {
+                _visible.push_back(static_cast<uint32_t>(f));
+            }
+        }
+        _stats.faces = face_count;
+        _stats.off_screen = counts[verdict_off_screen];
+        _stats.degenerate = counts[verdict_degenerate];
+        _stats.back_facing = counts[verdict_back_facing];
+        _stats.visible = counts[verdict_visible];
+    }
+
+    const std::vector<uint32_t>& visible() const
+    {
+        return _visible;
+    }
+
+    const cull_stats& stats() const
+    {
+        return _stats;
+    }
+
+    // transformed vertexes of the last run
+    const vertex_cache& vertexes() const
+    {
+        return _vertexes;
+    }
+
+private:
+    template<class index_t>
+    void classify(const index_t* corners, size_t face_count)
+    {
+        const float* x = _vertexes.x();
+        const float* y = _vertexes.y();
+        const uint8_t* codes = _vertexes.codes();
+        for (size_t f = 0; f < face_count; ++f)
+        {
+            const size_t a = corners[3*f];
+            const size_t b = corners[3*f + 1];
+            const size_t c = corners[3*f + 2];
+            const float area = (x[b] - x[a])*(y[c] - y[a]) - (y[b] - y[a])*(x[c] - x[a]);
+            const int codes_and = codes[a] & codes[b] & codes[c];
+            const int projected = !((codes[a] | codes[b] | codes[c]) & behind);
+            const int off_screen = (codes_and & ~behind) != 0;
+            const int degenerate = projected & (std::fabs(area) < min_area);
+            const int back_facing = projected & (area < 0.0f);
+            _verdicts[f] = static_cast<uint8_t>(off_screen ? verdict_off_screen
+                                                : degenerate ? verdict_degenerate
+                                                : back_facing ? verdict_back_facing
+                                                : verdict_visible);
+        }
+    }
+
+    static const int behind = vertex_cache::behind;
+
+    enum verdict
+    {
+        verdict_visible
+        ,verdict_off_screen
+        ,verdict_degenerate
+        ,verdict_back_facing
+        ,verdicts_count
+    };
+
+    vertex_cache _vertexes;
+    std::vector<uint8_t> _verdicts;
+    std::vector<uint32_t> _visible;
+    cull_stats _stats;
+};
+
+} // end of namespace render
+
+#endif // CULL_HPP
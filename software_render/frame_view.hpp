@@ -0,0 +1,78 @@
+#ifndef FRAME_VIEW_HPP
+#define FRAME_VIEW_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace render
+{
+
+// Non owning view of a 32 bit color buffer, what the rasterizers draw into.
+// Rows are addressed bottom up like the render space whichever way they run
+// in memory, pitch is in bytes and may include padding. The view is a pointer
+// and a stride, copying it does not copy pixels and a const view still writes.
+class frame_view
+{
+public:
+    frame_view() :
+        _origin(nullptr)
+      , _stride(0)
+      , _width(0)
+      , _height(0)
+    {}
+
+    // pixels is the first row in memory, the top one when top_down is set.
+    frame_view(void* pixels, int pitch, int width, int height, bool top_down = true) :
+        _origin(static_cast<uint8_t*>(pixels))
+      , _stride(top_down ? -static_cast<ptrdiff_t>(pitch) : pitch)
+      , _width(width)
+      , _height(height)
+    {
+        if (top_down && height > 0)
+        {
+            _origin += static_cast<ptrdiff_t>(height - 1)*pitch;
+        }
+    }
+
+    int width() const
+    {
+        return _width;
+    }
+
+    int height() const
+    {
+        return _height;
+    }
+
+    bool empty() const
+    {
+        return _origin == nullptr || _width <= 0 || _height <= 0;
+    }
+
+    uint32_t* row(int y) const
+    {
+        return reinterpret_cast<uint32_t*>(_origin + static_cast<ptrdiff_t>(y)*_stride);
+    }
+
+    uint32_t& at(int x, int y) const
+    {
+        return row(y)[x];
+    }
+
+    // Writes color to pixels [x0, x1] of row y.
+    void fill(int x0, int x1, int y, uint32_t color) const
+    {
+        std::fill(row(y) + x0, row(y) + x1 + 1, color);
+    }
+
+private:
+    uint8_t* _origin; // row y = 0
+    ptrdiff_t _stride;
+    int _width;
+    int _height;
+};
+
+} // end of namespace render
+
+#endif // FRAME_VIEW_HPP
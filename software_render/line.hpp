@@ -1,14 +1,37 @@
 #ifndef LINE_HPP
 #define LINE_HPP
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "geometry/geometry.hpp"
-#include "sdl/sdl.hpp"
+
+#include "frame_view.hpp"
 
 namespace render
 {
 
-inline void line_new(int x0, int y0, int x1, int y1, sdl_texture& image, const uint32_t& color)
+// True when both ends are beyond the same image border.
+inline bool line_outside(int x0, int y0, int x1, int y1, int width, int height)
+{
+    return (x0 < 0 && x1 < 0) || (x0 >= width && x1 >= width)
+        || (y0 < 0 && y1 < 0) || (y0 >= height && y1 >= height);
+}
+
+inline bool in_image(int x, int y, int width, int height)
+{
+    return static_cast<unsigned>(x) < static_cast<unsigned>(width)
+        && static_cast<unsigned>(y) < static_cast<unsigned>(height);
+}
+
+inline void line_new(int x0, int y0, int x1, int y1, const frame_view& image, const uint32_t& color)
 { // Bresenham's line algorithm
+    const int width = image.width();
+    const int height = image.height();
+    if (line_outside(x0, y0, x1, y1, width, height))
+    {
+        return;
+    }
     int delta_max = std::max(std::abs(x0-x1),std::abs(y0-y1));
 
     for (int t = 0
@@ -28,7 +51,10 @@ inline void line_new(int x0, int y0, int x1, int y1, sdl_texture& image, const u
                   , x_error += dx_error
                   , y_error += dy_error)
     {
-        image.at(x, y) = color;
+        if (in_image(x, y, width, height))
+        {
+            image.at(x, y) = color;
+        }
         int m =  (((uint32_t)(x_error + delta_max_minus) & 0x80000000)>>31)^0x00000001;
         x += dx * m;
         x_error -= 2*m*delta_max;
@@ -38,8 +64,14 @@ inline void line_new(int x0, int y0, int x1, int y1, sdl_texture& image, const u
     }
 }
 
-inline void line(int x0, int y0, int x1, int y1, sdl_texture& image, const uint32_t& color)
+inline void line(int x0, int y0, int x1, int y1, const frame_view& image, const uint32_t& color)
 { // Bresenham's line algorithm
+    const int width = image.width();
+    const int height = image.height();
+    if (line_outside(x0, y0, x1, y1, width, height))
+    {
+        return;
+    }
     bool transposed = false;
     if (std::abs(x0-x1) < std::abs(y0-y1))
     {
@@ -65,9 +97,15 @@ inline void line(int x0, int y0, int x1, int y1, sdl_texture& image, const uint3
                     y_error += dy_error)
     {
         if (transposed) {
-            image.at(y, x) = color;
+            if (in_image(y, x, width, height))
+            {
+                image.at(y, x) = color;
+            }
         } else {
-            image.at(x, y) = color;
+            if (in_image(x, y, width, height))
+            {
+                image.at(x, y) = color;
+            }
         }
         if (y_error > dx_error)
         {
@@ -77,12 +115,12 @@ inline void line(int x0, int y0, int x1, int y1, sdl_texture& image, const uint3
     }
 }
 
-inline void line(const cmn::vec2i& st, const cmn::vec2i& fn, sdl_texture& image, const uint32_t& color)
+inline void line(const cmn::vec2i& st, const cmn::vec2i& fn, const frame_view& image, const uint32_t& color)
 {
     line(st.x(), st.y(), fn.x(), fn.y(), image, color);
 }
 
-inline void line(const line2d& ln, sdl_texture& image, const uint32_t& color)
+inline void line(const line2d& ln, const frame_view& image, const uint32_t& color)
 {
     line(ln[0], ln[1], image, color);
 }
@@ -3,27 +3,40 @@
 
 #include "geometry/geometry.hpp"
 #include "model/model.hpp"
-#include "sdl/sdl.hpp"
 
+#include "frame_view.hpp"
 #include "line.hpp"
+#include "vertex_cache.hpp"
 
 namespace render
 {
-    inline void mesh(model& m, sdl_texture& image, const uint32_t& color)
+    // vertexes must have been run on m at the image size. Faces go through
+    // clip_triangle like the shaded ones, so no screen position of a vertex
+    // behind the camera or far outside the guard band reaches the int casts.
+    inline void mesh(const model& m, const vertex_cache& vertexes, const frame_view& image, const uint32_t& color)
     {
-        for (auto& face: m.faces)
+        const int width = image.width();
+        const int height = image.height();
+        for (size_t f = 0; f < m.faces_count(); ++f)
         {
-            for (int j=0; j<3; j++) {
-                cmn::vec3f v0 = m.vertexes[face.coords[j]];
-                cmn::vec3f v1 = m.vertexes[face.coords[(j+1)%3]];
-                int x0 = (v0.x()+1.)*image.width()/2.;
-                int y0 = (v0.y()+1.)*image.height()/2.;
-                int x1 = (v1.x()+1.)*image.width()/2.;
-                int y1 = (v1.y()+1.)*image.height()/2.;
-                line(x0, y0, x1, y1, image, color);
-            }
+            clip_triangle(vertexes, m.coord_indexes[3*f], m.coord_indexes[3*f + 1], m.coord_indexes[3*f + 2], width, height
+                          , [&image, &color](const triangle3d& screen_coords)
+            {
+                for (int j=0; j<3; j++) {
+                    const point3d& v0 = screen_coords[j];
+                    const point3d& v1 = screen_coords[(j+1)%3];
+                    line(static_cast<int>(v0.x()), static_cast<int>(v0.y()), static_cast<int>(v1.x()), static_cast<int>(v1.y()), image, color);
+                }
+            });
         }
     }
+
+    inline void mesh(const model& m, const frame_view& image, const uint32_t& color, const cmn::mat4& mvp = clip::fixed_camera())
+    {
+        vertex_cache vertexes;
+        vertexes.run(m, mvp, image.width(), image.height());
+        mesh(m, vertexes, image, color);
+    }
 }
 
 #endif // MEAH_HPP
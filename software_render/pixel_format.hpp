@@ -0,0 +1,56 @@
+#ifndef PIXEL_FORMAT_HPP
+#define PIXEL_FORMAT_HPP
+
+#include <cstdint>
+
+namespace render
+{
+
+// Packing of 8 bit channels into a 32 bit pixel. The default is ARGB8888,
+// presenters build the one of their display surface with from_masks.
+class pixel_format
+{
+public:
+    pixel_format() :
+        pixel_format(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000)
+    {}
+
+    pixel_format(uint32_t red_mask, uint32_t green_mask, uint32_t blue_mask, uint32_t alpha_mask) :
+        _red_shift(shift(red_mask))
+      , _green_shift(shift(green_mask))
+      , _blue_shift(shift(blue_mask))
+      , _alpha_shift(shift(alpha_mask))
+      , _alpha_mask(alpha_mask)
+    {}
+
+    uint32_t map_rgb(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 0) const
+    {
+        return (static_cast<uint32_t>(r) << _red_shift)
+             | (static_cast<uint32_t>(g) << _green_shift)
+             | (static_cast<uint32_t>(b) << _blue_shift)
+             | ((static_cast<uint32_t>(a) << _alpha_shift) & _alpha_mask);
+    }
+
+private:
+    // position of the lowest set bit, 0 for an absent channel
+    static int shift(uint32_t mask)
+    {
+        int bits = 0;
+        while (mask != 0 && !(mask & 1))
+        {
+            mask >>= 1;
+            ++bits;
+        }
+        return bits;
+    }
+
+    int _red_shift;
+    int _green_shift;
+    int _blue_shift;
+    int _alpha_shift;
+    uint32_t _alpha_mask;
+};
+
+} // end of namespace render
+
+#endif // PIXEL_FORMAT_HPP
@@ -0,0 +1,314 @@
+#ifndef RASTER_HPP
+#define RASTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "geometry/geometry.hpp"
+
+namespace render
+{
+
+namespace subpixel
+{
+    const int bits = 4;
+    typedef cmn::fixed<bits> coord; // 28.4 fixed point screen coordinate
+    typedef cmn::vec2<coord> point;
+    const int one = coord::one;
+    const int half = one >> 1;
+
+    // Largest coordinate the setup accepts, in pixels. Edge products of 28.4
+    // values this size stay well inside 64 bits. Clipping to the guard band
+    // keeps real geometry far below it.
+    const double max_coordinate = 1 << 24;
+
+    inline bool in_range(double value)
+    {
+        return value >= -max_coordinate && value <= max_coordinate;
+    }
+
+    // Snaps a screen position to the subpixel grid, the only rounding of
+    // the setup. Everything after it is exact integer arithmetic.
+    inline point snap(const point2d& value)
+    {
+        return point(coord(value.x()), coord(value.y()));
+    }
+}
+
+// E(p) = dx*(p.y - a.y) - dy*(p.x - a.x) of the directed edge a->b in 24.8,
+// positive on the left side. The top-left fill rule is folded into the
+// constant term, so a pixel center is covered when E(p) >= 0.
+class edge_function
+{
+public:
+    edge_function() :
+        step_x(0)
+      , step_y(0)
+      , _ax(0)
+      , _ay(0)
+      , _dx(0)
+      , _dy(0)
+      , _bias(0)
+    {}
+
+    edge_function(const subpixel::point& a, const subpixel::point& b) :
+        edge_function(a.x().raw(), a.y().raw(), (b.x() - a.x()).raw(), (b.y() - a.y()).raw())
+    {}
+
+    // y grows up in render space, so with the interior on the left a "top"
+    // edge runs in -x and a "left" edge runs in -y.
+    static bool is_top_left(int64_t dx, int64_t dy)
+    {
+        return (dy < 0) || (dy == 0 && dx < 0);
+    }
+
+    int64_t at(int x, int y) const
+    {
+        const int64_t px = static_cast<int64_t>(x)*subpixel::one + subpixel::half;
+        const int64_t py = static_cast<int64_t>(y)*subpixel::one + subpixel::half;
+        return _dx*(py - _ay) - _dy*(px - _ax) + _bias;
+    }
+
+    int64_t step_x;
+    int64_t step_y;
+
+private:
+    edge_function(int64_t ax, int64_t ay, int64_t dx, int64_t dy) :
+        step_x(-dy*subpixel::one)
+      , step_y(dx*subpixel::one)
+      , _ax(ax)
+      , _ay(ay)
+      , _dx(dx)
+      , _dy(dy)
+      , _bias(is_top_left(dx, dy) ? 0 : -1)
+    {}
+
+    int64_t _ax;
+    int64_t _ay;
+    int64_t _dx;
+    int64_t _dy;
+    int64_t _bias;
+};
+
+// Inclusive pixel rectangle, used for viewports, tiles and triangle bounds.
+class pixel_rect
+{
+public:
+    pixel_rect() :
+        min_x(0)
+      , min_y(0)
+      , max_x(-1)
+      , max_y(-1)
+    {}
+
+    pixel_rect(int min_x0, int min_y0, int max_x0, int max_y0) :
+        min_x(min_x0)
+      , min_y(min_y0)
+      , max_x(max_x0)
+      , max_y(max_y0)
+    {}
+
+    bool empty() const
+    {
+        return min_x > max_x || min_y > max_y;
+    }
+
+    pixel_rect intersect(const pixel_rect& that) const
+    {
+        return pixel_rect(std::max(min_x, that.min_x), std::max(min_y, that.min_y)
+                          , std::min(max_x, that.max_x), std::min(max_y, that.max_y));
+    }
+
+    int width() const
+    {
+        return max_x - min_x + 1;
+    }
+
+    int height() const
+    {
+        return max_y - min_y + 1;
+    }
+
+    int min_x;
+    int min_y;
+    int max_x;
+    int max_y;
+};
+
+// Per triangle setup: snapped vertexes, edge functions and the pixel bounds
+// clipped to the viewport. edges[i] is the edge opposite vertex i, so
+// edges[i].at(p)/area is the barycentric weight of vertex i whatever the
+// triangle winding is.
+class triangle_setup
+{
+public:
+    triangle_setup() :
+        area(0)
+      , extent(0)
+    {}
+
+    triangle_setup(const triangle2d& vertexes, const pixel_rect& viewport) :
+        area(0)
+      , extent(0)
+    {
+        std::array<subpixel::point, 3> p;
+        for (int i = 0; i < 3; ++i)
+        {
+            if (!subpixel::in_range(vertexes[i].x()) || !subpixel::in_range(vertexes[i].y()))
+            {
+                return;
+            }
+            p[i] = subpixel::snap(vertexes[i]);
+        }
+
+        const subpixel::point u = p[1] - p[0];
+        const subpixel::point v = p[2] - p[0];
+        area = (u.x().wide_mul(v.y()) - u.y().wide_mul(v.x())).raw();
+        if (area == 0)
+        {
+            return;
+        }
+        if (area > 0)
+        {
+            edges[0] = edge_function(p[1], p[2]);
+            edges[1] = edge_function(p[2], p[0]);
+            edges[2] = edge_function(p[0], p[1]);
+        }
+        else
+        {
+            edges[0] = edge_function(p[2], p[1]);
+            edges[1] = edge_function(p[0], p[2]);
+            edges[2] = edge_function(p[1], p[0]);
+            area = -area;
+        }
+
+        // first and last pixel centers inside the snapped bounds
+        const subpixel::coord half = subpixel::coord::from_raw(subpixel::half);
+        const int64_t first_x = (std::min({p[0].x(), p[1].x(), p[2].x()}) - half).ceil();
+        const int64_t first_y = (std::min({p[0].y(), p[1].y(), p[2].y()}) - half).ceil();
+        const int64_t last_x = (std::max({p[0].x(), p[1].x(), p[2].x()}) - half).floor();
+        const int64_t last_y = (std::max({p[0].y(), p[1].y(), p[2].y()}) - half).floor();
+        extent = std::max(last_x - first_x, last_y - first_y) + 1;
+        bounds = pixel_rect(std::max<int64_t>(viewport.min_x, first_x), std::max<int64_t>(viewport.min_y, first_y)
+                            , std::min<int64_t>(viewport.max_x, last_x), std::min<int64_t>(viewport.max_y, last_y));
+    }
+
+    triangle_setup(const triangle2d& vertexes, int width, int height) :
+        triangle_setup(vertexes, pixel_rect(0, 0, width - 1, height - 1))
+    {}
+
+    bool empty() const
+    {
+        return area == 0 || bounds.empty();
+    }
+
+    enum class coverage
+    {
+        outside
+        ,partial
+        ,inside
+    };
+
+    // Tests the pixel centers of block against all edges at once. The edge
+    // functions are affine, so their extremes over the block are at corners.
+    coverage classify(const pixel_rect& block) const
+    {
+        bool inside = true;
+        for (const edge_function& edge: edges)
+        {
+            const int64_t corner = edge.at(block.min_x, block.min_y);
+            const int64_t across = edge.step_x*(block.max_x - block.min_x);
+            const int64_t up = edge.step_y*(block.max_y - block.min_y);
+            const int64_t highest = corner + std::max<int64_t>(across, 0) + std::max<int64_t>(up, 0);
+            if (highest < 0)
+            {
+                return coverage::outside;
+            }
+            const int64_t lowest = corner + std::min<int64_t>(across, 0) + std::min<int64_t>(up, 0);
+            inside = inside && lowest >= 0;
+        }
+        return inside ? coverage::inside : coverage::partial;
+    }
+
+    std::array<edge_function, 3> edges;
+    int64_t area; // doubled, in 24.8
+    int64_t extent; // larger side of the bounds before viewport clipping
+    pixel_rect bounds;
+};
+
+// Vertex attribute interpolated linearly in screen space. It is evaluated
+// relative to the corner of the triangle bounds rather than accumulated,
+// so a pixel gets the same value whichever tile or clip rect it is drawn from.
+class attribute_plane
+{
+public:
+    attribute_plane() :
+        _origin_x(0)
+      , _origin_y(0)
+      , _value(0.0f)
+      , _dx(0.0f)
+      , _dy(0.0f)
+    {}
+
+    attribute_plane(const triangle_setup& setup, const std::array<float, 3>& values) :
+        _origin_x(setup.bounds.min_x)
+      , _origin_y(setup.bounds.min_y)
+      , _value(0.0f)
+      , _dx(0.0f)
+      , _dy(0.0f)
+    {
+        if (setup.area == 0)
+        {
+            return;
+        }
+        double value = 0.0, dx = 0.0, dy = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+            value += static_cast<double>(setup.edges[i].at(_origin_x, _origin_y))*values[i];
+            dx += static_cast<double>(setup.edges[i].step_x)*values[i];
+            dy += static_cast<double>(setup.edges[i].step_y)*values[i];
+        }
+        _value = value/setup.area;
+        _dx = dx/setup.area;
+        _dy = dy/setup.area;
+    }
+
+    // value at the bounds origin column of row y
+    float row(int y) const
+    {
+        return _value + _dy*(y - _origin_y);
+    }
+
+    float at(float row_value, int x) const
+    {
+        return row_value + _dx*(x - _origin_x);
+    }
+
+    float at(int x, int y) const
+    {
+        return at(row(y), x);
+    }
+
+    int origin_x() const
+    {
+        return _origin_x;
+    }
+
+    float dx() const
+    {
+        return _dx;
+    }
+
+private:
+    int _origin_x;
+    int _origin_y;
+    float _value;
+    float _dx;
+    float _dy;
+};
+
+} // end of namespace render
+
+#endif // RASTER_HPP
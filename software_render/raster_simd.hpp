@@ -0,0 +1,274 @@
+#ifndef RASTER_SIMD_HPP
+#define RASTER_SIMD_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "frame_view.hpp"
+#include "raster.hpp"
+#include "zbuffer.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define RENDER_SIMD_X86 1
+#define RENDER_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#else
+#define RENDER_SIMD_X86 0
+#endif
+
+namespace render
+{
+
+namespace simd
+{
+
+enum class kernel
+{
+    scalar
+    ,sse41
+    ,avx2
+};
+
+inline kernel detect()
+{
+#if RENDER_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return kernel::avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return kernel::sse41;
+    }
+#endif
+    return kernel::scalar;
+}
+
+// Kernel picked by the dispatchers, detected once. It may be lowered before
+// rendering starts to compare kernels on the same host.
+inline kernel& active_kernel()
+{
+    static kernel selected = detect();
+    return selected;
+}
+
+// Width and height of the blocks a kernel evaluates at once.
+inline int block_size(kernel selected)
+{
+    return selected == kernel::avx2 ? 8 : 4;
+}
+
+// The kernels step the edge functions in 32 bit lanes, which is exact as long
+// as the values at the corners of the box fit (they are affine, so the
+// corners bound every pixel in between).
+inline bool fits_lanes(const triangle_setup& setup, const pixel_rect& box)
+{
+    const int64_t limit = std::numeric_limits<int32_t>::max();
+    for (const edge_function& edge: setup.edges)
+    {
+        const int64_t corners[] = {edge.at(box.min_x, box.min_y), edge.at(box.max_x, box.min_y)
+                                   , edge.at(box.min_x, box.max_y), edge.at(box.max_x, box.max_y)};
+        for (const int64_t value: corners)
+        {
+            if (value > limit || value < -limit)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+#if RENDER_SIMD_X86
+
+// 4x4 blocks, one SSE register per block row. Partial blocks at the right
+// border of the box are written lane by lane.
+RENDER_TARGET("sse4.1")
+inline void triangle_3d_sse41(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                              , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const int block = 4;
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i offset[3], step_y[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        offset[i] = _mm_mullo_epi32(lanes, _mm_set1_epi32(static_cast<int32_t>(setup.edges[i].step_x)));
+        step_y[i] = _mm_set1_epi32(static_cast<int32_t>(setup.edges[i].step_y));
+    }
+    const __m128i colors = _mm_set1_epi32(static_cast<int32_t>(color));
+    const __m128 depth_dx = _mm_set1_ps(depth.dx());
+
+    for (int by = box.min_y; by <= box.max_y; by += block)
+    {
+        const int rows = std::min(block, box.max_y - by + 1);
+        for (int bx = box.min_x; bx <= box.max_x; bx += block)
+        {
+            const bool full = bx + block - 1 <= box.max_x;
+            const __m128i inside_x = _mm_cmpgt_epi32(_mm_set1_epi32(box.max_x - bx + 1), lanes);
+            const __m128 column = _mm_mul_ps(depth_dx, _mm_cvtepi32_ps(_mm_add_epi32(lanes, _mm_set1_epi32(bx - depth.origin_x()))));
+            __m128i w0 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(setup.edges[0].at(bx, by))), offset[0]);
+            __m128i w1 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(setup.edges[1].at(bx, by))), offset[1]);
+            __m128i w2 = _mm_add_epi32(_mm_set1_epi32(static_cast<int32_t>(setup.edges[2].at(bx, by))), offset[2]);
+            for (int r = 0; r < rows; ++r)
+            {
+                const int y = by + r;
+                const __m128i outside = _mm_srai_epi32(_mm_or_si128(_mm_or_si128(w0, w1), w2), 31);
+                const __m128i covered = _mm_andnot_si128(outside, inside_x);
+                if (!_mm_testz_si128(covered, covered))
+                {
+                    float* depth_ptr = zbuffer.row(y) + bx;
+                    uint32_t* color_ptr = image.row(y) + bx;
+                    const __m128 z = _mm_add_ps(_mm_set1_ps(depth.row(y)), column);
+                    if (full)
+                    {
+                        const __m128 current = _mm_loadu_ps(depth_ptr);
+                        const __m128 pass = _mm_and_ps(_mm_castsi128_ps(covered), _mm_cmplt_ps(z, current));
+                        _mm_storeu_ps(depth_ptr, _mm_blendv_ps(current, z, pass));
+                        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(color_ptr));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(color_ptr), _mm_blendv_epi8(pixels, colors, _mm_castps_si128(pass)));
+                    }
+                    else
+                    {
+                        float values[block];
+                        _mm_storeu_ps(values, z);
+                        const int mask = _mm_movemask_ps(_mm_castsi128_ps(covered));
+                        for (int lane = 0; lane < block; ++lane)
+                        {
+                            if ((mask & (1 << lane)) && values[lane] < depth_ptr[lane])
+                            {
+                                depth_ptr[lane] = values[lane];
+                                color_ptr[lane] = color;
+                            }
+                        }
+                    }
+                }
+                w0 = _mm_add_epi32(w0, step_y[0]);
+                w1 = _mm_add_epi32(w1, step_y[1]);
+                w2 = _mm_add_epi32(w2, step_y[2]);
+            }
+        }
+    }
+}
+
+// Depth tested fill of a box inside the triangle, 4 pixels per step.
+RENDER_TARGET("sse4.1")
+inline void fill_3d_sse41(const attribute_plane& depth, const pixel_rect& box
+                          , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const int block = 4;
+    const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i colors = _mm_set1_epi32(static_cast<int32_t>(color));
+    const __m128 depth_dx = _mm_set1_ps(depth.dx());
+    for (int y = box.min_y; y <= box.max_y; ++y)
+    {
+        const float depth_row = depth.row(y);
+        const __m128 row_value = _mm_set1_ps(depth_row);
+        float* depth_line = zbuffer.row(y);
+        uint32_t* pixels = image.row(y);
+        int x = box.min_x;
+        for (; x + block - 1 <= box.max_x; x += block)
+        {
+            const __m128 z = _mm_add_ps(row_value, _mm_mul_ps(depth_dx, _mm_cvtepi32_ps(_mm_add_epi32(lanes, _mm_set1_epi32(x - depth.origin_x())))));
+            const __m128 current = _mm_loadu_ps(depth_line + x);
+            const __m128 pass = _mm_cmplt_ps(z, current);
+            _mm_storeu_ps(depth_line + x, _mm_blendv_ps(current, z, pass));
+            const __m128i old_pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + x), _mm_blendv_epi8(old_pixels, colors, _mm_castps_si128(pass)));
+        }
+        for (; x <= box.max_x; ++x)
+        {
+            const float z = depth.at(depth_row, x);
+            if (z < depth_line[x])
+            {
+                depth_line[x] = z;
+                pixels[x] = color;
+            }
+        }
+    }
+}
+
+// 8x8 blocks, one AVX register per block row, masked loads and stores keep
+// partial blocks inside the buffers.
+RENDER_TARGET("avx2")
+inline void triangle_3d_avx2(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                             , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const int block = 8;
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i offset[3], step_y[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        offset[i] = _mm256_mullo_epi32(lanes, _mm256_set1_epi32(static_cast<int32_t>(setup.edges[i].step_x)));
+        step_y[i] = _mm256_set1_epi32(static_cast<int32_t>(setup.edges[i].step_y));
+    }
+    const __m256i colors = _mm256_set1_epi32(static_cast<int32_t>(color));
+    const __m256 depth_dx = _mm256_set1_ps(depth.dx());
+
+    for (int by = box.min_y; by <= box.max_y; by += block)
+    {
+        const int rows = std::min(block, box.max_y - by + 1);
+        for (int bx = box.min_x; bx <= box.max_x; bx += block)
+        {
+            const __m256i inside_x = _mm256_cmpgt_epi32(_mm256_set1_epi32(box.max_x - bx + 1), lanes);
+            const __m256 column = _mm256_mul_ps(depth_dx, _mm256_cvtepi32_ps(_mm256_add_epi32(lanes, _mm256_set1_epi32(bx - depth.origin_x()))));
+            __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(setup.edges[0].at(bx, by))), offset[0]);
+            __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(setup.edges[1].at(bx, by))), offset[1]);
+            __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int32_t>(setup.edges[2].at(bx, by))), offset[2]);
+            for (int r = 0; r < rows; ++r)
+            {
+                const int y = by + r;
+                const __m256i outside = _mm256_srai_epi32(_mm256_or_si256(_mm256_or_si256(w0, w1), w2), 31);
+                const __m256i covered = _mm256_andnot_si256(outside, inside_x);
+                if (!_mm256_testz_si256(covered, covered))
+                {
+                    float* depth_ptr = zbuffer.row(y) + bx;
+                    uint32_t* color_ptr = image.row(y) + bx;
+                    const __m256 z = _mm256_add_ps(_mm256_set1_ps(depth.row(y)), column);
+                    const __m256 current = _mm256_maskload_ps(depth_ptr, covered);
+                    const __m256i pass = _mm256_and_si256(covered, _mm256_castps_si256(_mm256_cmp_ps(z, current, _CMP_LT_OQ)));
+                    _mm256_maskstore_ps(depth_ptr, pass, z);
+                    _mm256_maskstore_epi32(reinterpret_cast<int*>(color_ptr), pass, colors);
+                }
+                w0 = _mm256_add_epi32(w0, step_y[0]);
+                w1 = _mm256_add_epi32(w1, step_y[1]);
+                w2 = _mm256_add_epi32(w2, step_y[2]);
+            }
+        }
+    }
+}
+
+// Depth tested fill of a box inside the triangle, 8 pixels per step.
+RENDER_TARGET("avx2")
+inline void fill_3d_avx2(const attribute_plane& depth, const pixel_rect& box
+                         , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const int block = 8;
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i colors = _mm256_set1_epi32(static_cast<int32_t>(color));
+    const __m256 depth_dx = _mm256_set1_ps(depth.dx());
+    for (int y = box.min_y; y <= box.max_y; ++y)
+    {
+        const __m256 row_value = _mm256_set1_ps(depth.row(y));
+        float* depth_line = zbuffer.row(y);
+        uint32_t* pixels = image.row(y);
+        for (int x = box.min_x; x <= box.max_x; x += block)
+        {
+            const __m256i inside_x = _mm256_cmpgt_epi32(_mm256_set1_epi32(box.max_x - x + 1), lanes);
+            const __m256 z = _mm256_add_ps(row_value, _mm256_mul_ps(depth_dx, _mm256_cvtepi32_ps(_mm256_add_epi32(lanes, _mm256_set1_epi32(x - depth.origin_x())))));
+            const __m256 current = _mm256_maskload_ps(depth_line + x, inside_x);
+            const __m256i pass = _mm256_and_si256(inside_x, _mm256_castps_si256(_mm256_cmp_ps(z, current, _CMP_LT_OQ)));
+            _mm256_maskstore_ps(depth_line + x, pass, z);
+            _mm256_maskstore_epi32(reinterpret_cast<int*>(pixels + x), pass, colors);
+        }
+    }
+}
+
+#endif // RENDER_SIMD_X86
+
+} // end of namespace simd
+
+} // end of namespace render
+
+#endif // RASTER_SIMD_HPP
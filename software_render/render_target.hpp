@@ -0,0 +1,107 @@
+#ifndef RENDER_TARGET_HPP
+#define RENDER_TARGET_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+#include "frame_view.hpp"
+#include "zbuffer.hpp"
+
+namespace render
+{
+
+// In memory color and depth buffers to render into, no display needed.
+// Color rows are packed top down like textures and image files, so a
+// presenter can copy them as they are.
+class render_target
+{
+public:
+    render_target() :
+        _width(0)
+      , _height(0)
+    {}
+
+    render_target(int width, int height) :
+        _width(0)
+      , _height(0)
+    {
+        resize(width, height);
+    }
+
+    // Reallocates and clears only when the size changes.
+    void resize(int width, int height)
+    {
+        if (width == _width && height == _height)
+        {
+            return;
+        }
+        _colors.reset(new uint32_t[static_cast<size_t>(width)*height]);
+        _width = width;
+        _height = height;
+        _depth.resize(width, height);
+        clear();
+    }
+
+    void clear(uint32_t color = 0)
+    {
+        clear_color(color);
+        _depth.clear();
+    }
+
+    void clear_color(uint32_t color)
+    {
+        std::fill_n(_colors.get(), static_cast<size_t>(_width)*_height, color);
+    }
+
+    int width() const
+    {
+        return _width;
+    }
+
+    int height() const
+    {
+        return _height;
+    }
+
+    // bytes per row
+    int pitch() const
+    {
+        return _width*static_cast<int>(sizeof(uint32_t));
+    }
+
+    uint32_t* pixels()
+    {
+        return _colors.get();
+    }
+
+    const uint32_t* pixels() const
+    {
+        return _colors.get();
+    }
+
+    frame_view view()
+    {
+        return frame_view(_colors.get(), pitch(), _width, _height);
+    }
+
+    z_buffer& depth()
+    {
+        return _depth;
+    }
+
+    const z_buffer& depth() const
+    {
+        return _depth;
+    }
+
+private:
+    std::unique_ptr<uint32_t[]> _colors;
+    z_buffer _depth;
+    int _width;
+    int _height;
+};
+
+} // end of namespace render
+
+#endif // RENDER_TARGET_HPP
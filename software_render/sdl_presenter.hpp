@@ -0,0 +1,75 @@
+#ifndef SDL_PRESENTER_HPP
+#define SDL_PRESENTER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "sdl/sdl.hpp"
+
+#include "frame_view.hpp"
+#include "pixel_format.hpp"
+#include "render_target.hpp"
+
+namespace render
+{
+
+// Pixel format of an SDL surface, read back from its pure channel colors.
+inline pixel_format surface_format(sdl_surface& surface)
+{
+    return pixel_format(surface.map_rgb(0xff, 0, 0, 0), surface.map_rgb(0, 0xff, 0, 0)
+                        , surface.map_rgb(0, 0, 0xff, 0), surface.map_rgb(0, 0, 0, 0xff) & ~surface.map_rgb(0, 0, 0, 0));
+}
+
+// Shows rendered frames in an SDL window. Either copies a render_target into
+// the streaming texture, or wraps the locked texture in a frame_view so the
+// renderer draws straight into it.
+class sdl_presenter
+{
+public:
+    explicit sdl_presenter(sdl_texture& texture) :
+        _texture(texture)
+    {}
+
+    // The view is valid until present.
+    frame_view lock()
+    {
+        _texture.lockTexture();
+        return frame_view(_texture.pixels(), _texture.pitch(), _texture.width(), _texture.height());
+    }
+
+    void present()
+    {
+        _texture.unlockTexture();
+        _texture.render();
+    }
+
+    void present(const render_target& target)
+    {
+        _texture.lockTexture();
+        uint8_t* destination = static_cast<uint8_t*>(_texture.pixels());
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(target.pixels());
+        const int rows = std::min(target.height(), _texture.height());
+        const size_t bytes = static_cast<size_t>(std::min(target.width(), _texture.width()))*sizeof(uint32_t);
+        if (_texture.pitch() == target.pitch() && target.width() == _texture.width())
+        {
+            std::memcpy(destination, source, bytes*rows);
+        }
+        else
+        {
+            for (int y = 0; y < rows; ++y)
+            {
+                std::memcpy(destination + static_cast<size_t>(y)*_texture.pitch()
+                            , source + static_cast<size_t>(y)*target.pitch(), bytes);
+            }
+        }
+        present();
+    }
+
+private:
+    sdl_texture& _texture;
+};
+
+} // end of namespace render
+
+#endif // SDL_PRESENTER_HPP
@@ -1,10 +1,19 @@
 #ifndef SOFTWARE_RENDERER_HPP
 #define SOFTWARE_RENDERER_HPP
 
+#include "clip.hpp"
+#include "cull.hpp"
+#include "frame_view.hpp"
 #include "line.hpp"
+#include "raster.hpp"
+#include "raster_simd.hpp"
 #include "triangle.hpp"
+#include "tiles.hpp"
 #include "mesh.hpp"
+#include "pixel_format.hpp"
+#include "render_target.hpp"
 #include "surf.hpp"
+#include "vertex_cache.hpp"
 #include "zbuffer.hpp"
 
 #endif // SOFTWARE_RENDERER_HPP
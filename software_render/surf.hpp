@@ -2,35 +2,114 @@
 #define SURF_HPP
 
 #include <algorithm>
+#include <vector>
 
 #include "geometry/geometry.hpp"
 #include "model/model.hpp"
-#include "sdl/sdl.hpp"
+#include "model/quantized_mesh.hpp"
 
+#include "clip.hpp"
+#include "cull.hpp"
+#include "frame_view.hpp"
+#include "pixel_format.hpp"
+#include "render_target.hpp"
 #include "triangle.hpp"
+#include "tiles.hpp"
+#include "vertex_cache.hpp"
+#include "zbuffer.hpp"
 
 namespace render
 {
-    inline void surf(model& m, sdl_texture& image, sdl_surface& screen_surface, cmn::vec3f light_dir)
+    // Unit outward normal of face idx, computed only when the model's
+    // normals are out of date.
+    inline point3d face_normal(const model& m, size_t idx)
     {
-        for (auto& face: m.faces)
+        if (m.normals_updated())
         {
-            triangle2d screen_coords;
-            triangle3d world_coords;
-            for (int j=0; j<3; j++)
-            {
-                point3d &v = m.vertexes[face.coords[j]];
-                screen_coords[j] = point2d((v.x() + 1.)*image.width()/2. , (v.y() + 1.)*image.height()/2.);
-                world_coords[j]  = v;
-            }
-            point3d n = (world_coords[2]-world_coords[0]).vec_prod(world_coords[1]-world_coords[0]);
-            n = n.normalize();
-            float intensity = n*light_dir;
+            return m.face_normals.get(idx);
+        }
+        const point3d& a = m.vertexes[m.coord_indexes[3*idx]];
+        const point3d& b = m.vertexes[m.coord_indexes[3*idx + 1]];
+        const point3d& c = m.vertexes[m.coord_indexes[3*idx + 2]];
+        return (b-a).vec_prod(c-a).normalize();
+    }
+
+    inline point3d face_normal(const quantized_mesh& m, size_t idx)
+    {
+        return m.face_normal(idx);
+    }
+
+    // Flat shades the faces that survived culling, handing the clipped screen
+    // triangles and their color to emit. Positions come from the culler's
+    // vertex cache and normals from the mesh, nothing is transformed per
+    // corner. mesh_t is a model or a quantized_mesh.
+    template<class mesh_t, class emit_t>
+    inline void shade_faces(const mesh_t& m, const face_culler& culler, int width, int height
+                            , const pixel_format& format, const cmn::vec3f& light_dir, emit_t emit)
+    {
+        const cmn::vec3s light(light_dir);
+        for (const uint32_t idx: culler.visible())
+        {
+            const uint32_t a = m.coord_indexes[3*idx];
+            const uint32_t b = m.coord_indexes[3*idx + 1];
+            const uint32_t c = m.coord_indexes[3*idx + 2];
+            const cmn::vec3s n(face_normal(m, idx));
+            float intensity = -(n*light);
             if (intensity>0) {
-                triangle(screen_coords, image, screen_surface.map_rgb(intensity*255, intensity*255, intensity*255));
+                const uint32_t color = format.map_rgb(intensity*255, intensity*255, intensity*255);
+                clip_triangle(culler.vertexes(), a, b, c, width, height, [&emit, color](const triangle3d& screen_coords)
+                {
+                    emit(screen_coords, color);
+                });
             }
         }
     }
+
+    // zbuffer follows the image size but is not cleared here, so several
+    // models can share it in one frame. mvp takes the mesh to clip space and
+    // light_dir stays in the mesh's own space, a caller that moves the model
+    // rotates the light the other way.
+    template<class mesh_t>
+    inline void surf(const mesh_t& m, const frame_view& image, const pixel_format& format, cmn::vec3f light_dir, z_buffer& zbuffer
+                     , face_culler& culler, const cmn::mat4& mvp = clip::fixed_camera())
+    {
+        zbuffer.resize(image.width(), image.height());
+        culler.run(m, mvp, image.width(), image.height());
+        shade_faces(m, culler, image.width(), image.height(), format, light_dir
+                    , [&image, &zbuffer](const triangle3d& screen_coords, const uint32_t& color)
+        {
+            triangle_3d(screen_coords, image, color, zbuffer);
+        });
+    }
+
+    template<class mesh_t>
+    inline void surf(const mesh_t& m, const frame_view& image, const pixel_format& format, cmn::vec3f light_dir, z_buffer& zbuffer
+                     , face_culler& culler, tile_pipeline& pipeline, const cmn::mat4& mvp = clip::fixed_camera())
+    {
+        zbuffer.resize(image.width(), image.height());
+        culler.run(m, mvp, image.width(), image.height());
+        pipeline.begin(image.width(), image.height());
+        shade_faces(m, culler, image.width(), image.height(), format, light_dir
+                    , [&pipeline](const triangle3d& screen_coords, const uint32_t& color)
+        {
+            pipeline.add(screen_coords, color);
+        });
+        pipeline.flush(image, zbuffer);
+    }
+
+    template<class mesh_t>
+    inline void surf(const mesh_t& m, render_target& target, const pixel_format& format, cmn::vec3f light_dir, face_culler& culler
+                     , const cmn::mat4& mvp = clip::fixed_camera())
+    {
+        surf(m, target.view(), format, light_dir, target.depth(), culler, mvp);
+    }
+
+    template<class mesh_t>
+    inline void surf(const mesh_t& m, render_target& target, const pixel_format& format, cmn::vec3f light_dir
+                     , face_culler& culler, tile_pipeline& pipeline, const cmn::mat4& mvp = clip::fixed_camera())
+    {
+        surf(m, target.view(), format, light_dir, target.depth(), culler, pipeline, mvp);
+    }
 }
 
 #endif // SURF_HPP
@@ -0,0 +1,114 @@
+#ifndef TILES_HPP
+#define TILES_HPP
+
+#include <algorithm>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+#include "parallel/thread_pool.hpp"
+
+#include "frame_view.hpp"
+#include "raster.hpp"
+#include "triangle.hpp"
+#include "zbuffer.hpp"
+
+namespace render
+{
+
+// Sort-middle pipeline: triangles are set up and binned into the screen tiles
+// they overlap, then the tiles are rasterized independently on the pool.
+// A tile's colors and depths are only ever touched by one thread, and
+// triangles keep their submission order inside a bin.
+class tile_pipeline
+{
+public:
+    explicit tile_pipeline(int tile_size = 64, unsigned threads = parallel::thread_pool::default_size()) :
+        _tile_size(tile_size)
+      , _tiles_x(0)
+      , _tiles_y(0)
+      , _pool(threads)
+    {}
+
+    int tile_size() const
+    {
+        return _tile_size;
+    }
+
+    void begin(int width, int height)
+    {
+        _viewport = pixel_rect(0, 0, width - 1, height - 1);
+        _tiles_x = (width + _tile_size - 1)/_tile_size;
+        _tiles_y = (height + _tile_size - 1)/_tile_size;
+        _bins.resize(_tiles_x*_tiles_y);
+        for (auto& bin: _bins)
+        {
+            bin.clear();
+        }
+        _triangles.clear();
+    }
+
+    void add(const triangle3d& vertexes, const uint32_t& color)
+    {
+        const triangle_setup setup(triangle2d{{point2d(vertexes[0].x(), vertexes[0].y())
+                                               , point2d(vertexes[1].x(), vertexes[1].y())
+                                               , point2d(vertexes[2].x(), vertexes[2].y())}}
+                                   , _viewport);
+        if (setup.empty())
+        {
+            return;
+        }
+        const attribute_plane depth(setup, {{static_cast<float>(vertexes[0].z())
+                                             , static_cast<float>(vertexes[1].z())
+                                             , static_cast<float>(vertexes[2].z())}});
+        const uint32_t idx = static_cast<uint32_t>(_triangles.size());
+        _triangles.push_back(binned_triangle{setup, depth, color});
+
+        const int first_x = setup.bounds.min_x/_tile_size;
+        const int first_y = setup.bounds.min_y/_tile_size;
+        const int last_x = setup.bounds.max_x/_tile_size;
+        const int last_y = setup.bounds.max_y/_tile_size;
+        for (int ty = first_y; ty <= last_y; ++ty)
+        {
+            for (int tx = first_x; tx <= last_x; ++tx)
+            {
+                _bins[ty*_tiles_x + tx].push_back(idx);
+            }
+        }
+    }
+
+    void flush(const frame_view& image, z_buffer& zbuffer)
+    {
+        _pool.parallel_for(_bins.size(), [this, &image, &zbuffer](size_t tile)
+        {
+            const int tx = static_cast<int>(tile)%_tiles_x;
+            const int ty = static_cast<int>(tile)/_tiles_x;
+            const pixel_rect rect = pixel_rect(tx*_tile_size, ty*_tile_size
+                                               , (tx + 1)*_tile_size - 1, (ty + 1)*_tile_size - 1).intersect(_viewport);
+            for (const uint32_t idx: _bins[tile])
+            {
+                const binned_triangle& tr = _triangles[idx];
+                triangle_3d(tr.setup, tr.depth, rect, image, tr.color, zbuffer);
+            }
+        });
+    }
+
+private:
+    struct binned_triangle
+    {
+        triangle_setup setup;
+        attribute_plane depth;
+        uint32_t color;
+    };
+
+    int _tile_size;
+    int _tiles_x;
+    int _tiles_y;
+    pixel_rect _viewport;
+    std::vector<binned_triangle> _triangles;
+    std::vector<std::vector<uint32_t>> _bins;
+    parallel::thread_pool _pool;
+};
+
+} // end of namespace render
+
+#endif // TILES_HPP
@@ -2,64 +2,329 @@
 #define TRIANGLE_HPP
 
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 
 #include "geometry/geometry.hpp"
 #include "common.hpp"
+#include "frame_view.hpp"
+#include "raster.hpp"
+#include "raster_simd.hpp"
 
 #include "zbuffer.hpp"
 
 namespace render
 {
 
-//inline bool in_triangle (const double &detT, const point2d &lambda0_k0, const point2d &lambda1_k0, const triangle2d &vertexes, const point2d& p)
-//{
-//    const point2d tmp = p - vertexes[2];
-//    const double lambda0 = lambda0_k0*tmp;
-//    const double lambda1 = lambda1_k0*tmp;
-//    const double lambda2 = detT - lambda0 - lambda1;
-//    return (lambda0*detT >= 0.0) && (lambda1*detT >= 0.0) && (lambda2*detT >= 0.0);
-//}
+// Rasterizes the part of a set up triangle that falls into clip.
+inline void triangle(const triangle_setup& setup, const pixel_rect& clip, const frame_view& image, const uint32_t &color)
+{
+    const pixel_rect box = setup.bounds.intersect(clip);
+    if (setup.area == 0 || box.empty())
+    {
+        return;
+    }
+    const edge_function& e0 = setup.edges[0];
+    const edge_function& e1 = setup.edges[1];
+    const edge_function& e2 = setup.edges[2];
+
+    int64_t row0 = e0.at(box.min_x, box.min_y);
+    int64_t row1 = e1.at(box.min_x, box.min_y);
+    int64_t row2 = e2.at(box.min_x, box.min_y);
+    for(int y = box.min_y; y <= box.max_y; ++y)
+    {
+        int64_t w0 = row0;
+        int64_t w1 = row1;
+        int64_t w2 = row2;
+        uint32_t* pixel = image.row(y) + box.min_x;
+        for(int x = box.min_x; x <= box.max_x; ++x, ++pixel)
+        {
+            if ((w0 | w1 | w2) >= 0)
+            {
+                *pixel = color;
+            }
+            w0 += e0.step_x;
+            w1 += e1.step_x;
+            w2 += e2.step_x;
+        }
+        row0 += e0.step_y;
+        row1 += e1.step_y;
+        row2 += e2.step_y;
+    }
+}
+
+inline void triangle(const triangle2d &vertexes, const frame_view& image, const uint32_t &color)
+{
+    const triangle_setup setup(vertexes, image.width(), image.height());
+    triangle(setup, setup.bounds, image, color);
+}
 
-inline void triangle(const triangle2d &vertexes, sdl_texture &image, const uint32_t &color)
+// Depth tested rasterization of a set up triangle inside box, depth is the
+// screen space interpolated z from the plane.
+inline void triangle_3d_scalar(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                               , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
 {
-    std::array<point2d, 3> sizes = {{
-                                          (vertexes[0] - vertexes[1]).abs(),
-                                          (vertexes[1] - vertexes[2]).abs(),
-                                          (vertexes[2] - vertexes[0]).abs()
-                                      }};
-    float width = std::max_element(sizes.begin(), sizes.end(), [](const point2d& l, const point2d& r) {return l.x() < r.x();})->x();
-    float height = std::max_element(sizes.begin(), sizes.end(), [](const point2d& l, const point2d& r) {return l.y() < r.y();})->y();
-    float anchor_x = std::min_element(vertexes.begin(), vertexes.end(), [](const point2d& l, const point2d& r) {return l.x() < r.x();})->x();
-    float anchor_y = std::min_element(vertexes.begin(), vertexes.end(), [](const point2d& l, const point2d& r) {return l.y() < r.y();})->y();
-
-    const double detT = (vertexes[0].x() - vertexes[2].x())*(vertexes[1].y() - vertexes[2].y())
-                    - (vertexes[0].y() - vertexes[2].y())*(vertexes[1].x() - vertexes[2].x());
-    const point2d lambda0_k0((vertexes[1].y() - vertexes[2].y()), (vertexes[2].x() - vertexes[1].x()));
-    const point2d lambda1_k0((vertexes[2].y() - vertexes[0].y()), (vertexes[0].x() - vertexes[2].x()));
-
-    const auto in_triangle = [detT, lambda0_k0, lambda1_k0](const point2d& p) -> bool
-    {
-        const double lambda0 = lambda0_k0*p;
-        const double lambda1 = lambda1_k0*p;
-        const double lambda2 = detT - lambda0 - lambda1;
-        return (lambda0*detT >= 0.0) && (lambda1*detT >= 0.0) && (lambda2*detT >= 0.0);
-    };
-
-    for(float y = anchor_y; y < anchor_y + height; ++y)
-    {
-        for(float x = anchor_x; x < anchor_x + width; ++x)
+    const edge_function& e0 = setup.edges[0];
+    const edge_function& e1 = setup.edges[1];
+    const edge_function& e2 = setup.edges[2];
+
+    int64_t row0 = e0.at(box.min_x, box.min_y);
+    int64_t row1 = e1.at(box.min_x, box.min_y);
+    int64_t row2 = e2.at(box.min_x, box.min_y);
+    for(int y = box.min_y; y <= box.max_y; ++y)
+    {
+        int64_t w0 = row0;
+        int64_t w1 = row1;
+        int64_t w2 = row2;
+        const float depth_row = depth.row(y);
+        float* depth_line = zbuffer.row(y);
+        uint32_t* pixels = image.row(y);
+        for(int x = box.min_x; x <= box.max_x; ++x)
         {
-            if (in_triangle(point2d(x,y) - vertexes[2]))
-            //if (in_triangle(detT, lambda0_k0, lambda1_k0, vertexes, point2d(x,y)))
+            if ((w0 | w1 | w2) >= 0)
             {
-                image.at(x,y) = color;
+                const float z = depth.at(depth_row, x);
+                const bool pass = z < depth_line[x];
+                depth_line[x] = pass ? z : depth_line[x];
+                pixels[x] = pass ? color : pixels[x];
             }
+            w0 += e0.step_x;
+            w1 += e1.step_x;
+            w2 += e2.step_x;
+        }
+        row0 += e0.step_y;
+        row1 += e1.step_y;
+        row2 += e2.step_y;
+    }
+}
+
+// Depth tested fill of a block known to be inside the triangle, no coverage
+// tests at all.
+inline void fill_3d_scalar(const attribute_plane& depth, const pixel_rect& box
+                           , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    for(int y = box.min_y; y <= box.max_y; ++y)
+    {
+        const float depth_row = depth.row(y);
+        float* depth_line = zbuffer.row(y);
+        uint32_t* pixels = image.row(y);
+        for(int x = box.min_x; x <= box.max_x; ++x)
+        {
+            const float z = depth.at(depth_row, x);
+            const bool pass = z < depth_line[x];
+            depth_line[x] = pass ? z : depth_line[x];
+            pixels[x] = pass ? color : pixels[x];
         }
     }
 }
 
-inline void triangle_3d(const triangle3d &vertexes, sdl_texture& image, const uint32_t& color, z_buffer& zbuffer)
+inline void fill_3d(const attribute_plane& depth, const pixel_rect& box
+                    , const frame_view& image, const uint32_t& color, z_buffer& zbuffer, simd::kernel kernel)
+{
+#if RENDER_SIMD_X86
+    if (kernel == simd::kernel::avx2)
+    {
+        simd::fill_3d_avx2(depth, box, image, color, zbuffer);
+        return;
+    }
+    if (kernel == simd::kernel::sse41)
+    {
+        simd::fill_3d_sse41(depth, box, image, color, zbuffer);
+        return;
+    }
+#endif
+    fill_3d_scalar(depth, box, image, color, zbuffer);
+}
+
+// Per pixel coverage of box with the given kernel.
+inline void triangle_3d_pixels(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                               , const frame_view& image, const uint32_t& color, z_buffer& zbuffer, simd::kernel kernel)
+{
+#if RENDER_SIMD_X86
+    if (kernel == simd::kernel::avx2)
+    {
+        simd::triangle_3d_avx2(setup, depth, box, image, color, zbuffer);
+        return;
+    }
+    if (kernel == simd::kernel::sse41)
+    {
+        simd::triangle_3d_sse41(setup, depth, box, image, color, zbuffer);
+        return;
+    }
+#endif
+    triangle_3d_scalar(setup, depth, box, image, color, zbuffer);
+}
+
+namespace hierarchy
+{
+    const int coarse = 16;
+    const int min_size = 2*coarse; // smaller boxes go straight to the pixel kernels
+}
+
+namespace small_triangle
+{
+    const int max_size = 8; // one AVX2 block, four SSE blocks
+}
+
+// Number of triangle_3d calls that took each path. A triangle drawn through
+// the tile pipeline is counted once per tile it is binned to. Relaxed
+// atomics, the tile workers share them.
+class raster_stats
+{
+public:
+    raster_stats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        small = 0;
+        pixels = 0;
+        hierarchical = 0;
+    }
+
+    std::atomic<uint64_t> small;
+    std::atomic<uint64_t> pixels;
+    std::atomic<uint64_t> hierarchical;
+};
+
+inline raster_stats& stats()
+{
+    static raster_stats counters;
+    return counters;
+}
+
+// Triangles whose whole bounds fit in one small block: the edge values are
+// tiny, so they are stepped in 32 bits over a fixed size box without the
+// lane range check or the hierarchy.
+inline void triangle_3d_small(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                              , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const simd::kernel kernel = simd::active_kernel();
+    if (kernel != simd::kernel::scalar)
+    {
+        triangle_3d_pixels(setup, depth, box, image, color, zbuffer, kernel);
+        return;
+    }
+    int32_t step_x[3], step_y[3], row[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        step_x[i] = static_cast<int32_t>(setup.edges[i].step_x);
+        step_y[i] = static_cast<int32_t>(setup.edges[i].step_y);
+        row[i] = static_cast<int32_t>(setup.edges[i].at(box.min_x, box.min_y));
+    }
+    const int columns = box.width();
+    for (int y = box.min_y; y <= box.max_y; ++y)
+    {
+        const float depth_row = depth.row(y);
+        float* depth_line = zbuffer.row(y) + box.min_x;
+        uint32_t* pixels = image.row(y) + box.min_x;
+        for (int x = 0; x < small_triangle::max_size; ++x)
+        {
+            const int32_t w = (row[0] + step_x[0]*x) | (row[1] + step_x[1]*x) | (row[2] + step_x[2]*x);
+            if (x < columns && w >= 0)
+            {
+                const float z = depth.at(depth_row, box.min_x + x);
+                const bool pass = z < depth_line[x];
+                depth_line[x] = pass ? z : depth_line[x];
+                pixels[x] = pass ? color : pixels[x];
+            }
+        }
+        row[0] += step_y[0];
+        row[1] += step_y[1];
+        row[2] += step_y[2];
+    }
+}
+
+// Walks box in 16x16 blocks, then in the kernel's own blocks (4x4, 8x8 for
+// AVX2) inside the partially covered ones. Blocks outside an edge are
+// skipped and blocks inside all edges are filled, so only blocks crossing an
+// edge pay for per pixel coverage.
+inline void triangle_3d_hierarchical(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& box
+                                     , const frame_view& image, const uint32_t& color, z_buffer& zbuffer, simd::kernel kernel)
+{
+    const int fine = simd::block_size(kernel);
+    for (int by = box.min_y & ~(hierarchy::coarse - 1); by <= box.max_y; by += hierarchy::coarse)
+    {
+        for (int bx = box.min_x & ~(hierarchy::coarse - 1); bx <= box.max_x; bx += hierarchy::coarse)
+        {
+            const pixel_rect block = pixel_rect(bx, by, bx + hierarchy::coarse - 1, by + hierarchy::coarse - 1).intersect(box);
+            const triangle_setup::coverage coarse_coverage = setup.classify(block);
+            if (coarse_coverage == triangle_setup::coverage::outside)
+            {
+                continue;
+            }
+            if (coarse_coverage == triangle_setup::coverage::inside)
+            {
+                fill_3d(depth, block, image, color, zbuffer, kernel);
+                continue;
+            }
+            for (int fy = by; fy <= block.max_y; fy += fine)
+            {
+                for (int fx = bx; fx <= block.max_x; fx += fine)
+                {
+                    const pixel_rect sub_block = pixel_rect(fx, fy, fx + fine - 1, fy + fine - 1).intersect(block);
+                    if (sub_block.empty())
+                    {
+                        continue;
+                    }
+                    const triangle_setup::coverage fine_coverage = setup.classify(sub_block);
+                    if (fine_coverage == triangle_setup::coverage::inside)
+                    {
+                        fill_3d(depth, sub_block, image, color, zbuffer, kernel);
+                    }
+                    else if (fine_coverage == triangle_setup::coverage::partial)
+                    {
+                        triangle_3d_pixels(setup, depth, sub_block, image, color, zbuffer, kernel);
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void triangle_3d(const triangle_setup& setup, const attribute_plane& depth, const pixel_rect& clip
+                        , const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
+{
+    const pixel_rect box = setup.bounds.intersect(clip);
+    if (setup.area == 0 || box.empty())
+    {
+        return;
+    }
+    if (setup.extent <= small_triangle::max_size)
+    {
+        stats().small.fetch_add(1, std::memory_order_relaxed);
+        triangle_3d_small(setup, depth, box, image, color, zbuffer);
+        return;
+    }
+    simd::kernel kernel = simd::active_kernel();
+    if (kernel != simd::kernel::scalar && !simd::fits_lanes(setup, box))
+    {
+        kernel = simd::kernel::scalar;
+    }
+    if (box.width() >= hierarchy::min_size && box.height() >= hierarchy::min_size)
+    {
+        stats().hierarchical.fetch_add(1, std::memory_order_relaxed);
+        triangle_3d_hierarchical(setup, depth, box, image, color, zbuffer, kernel);
+    }
+    else
+    {
+        stats().pixels.fetch_add(1, std::memory_order_relaxed);
+        triangle_3d_pixels(setup, depth, box, image, color, zbuffer, kernel);
+    }
+}
+
+inline void triangle_3d(const triangle3d &vertexes, const frame_view& image, const uint32_t& color, z_buffer& zbuffer)
 {
+    const triangle_setup setup(triangle2d{{point2d(vertexes[0].x(), vertexes[0].y())
+                                           , point2d(vertexes[1].x(), vertexes[1].y())
+                                           , point2d(vertexes[2].x(), vertexes[2].y())}}
+                               , pixel_rect(0, 0, zbuffer.width() - 1, zbuffer.height() - 1));
+    const attribute_plane depth(setup, {{static_cast<float>(vertexes[0].z())
+                                         , static_cast<float>(vertexes[1].z())
+                                         , static_cast<float>(vertexes[2].z())}});
+    triangle_3d(setup, depth, setup.bounds, image, color, zbuffer);
 }
 
 } // end of namespace render
@@ -0,0 +1,213 @@
+#ifndef VERTEX_CACHE_HPP
+#define VERTEX_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "geometry/geometry.hpp"
+#include "model/model.hpp"
+#include "model/quantized_mesh.hpp"
+
+#include "clip.hpp"
+
+namespace render
+{
+
+// Vertex work of the last vertex_cache::run against the face corners that
+// would have been transformed one by one.
+class vertex_stats
+{
+public:
+    vertex_stats()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        transformed = 0;
+        corners = 0;
+    }
+
+    uint64_t transformed;
+    uint64_t corners;
+};
+
+// Post-transform vertex stage. Every vertex of the model is taken to clip
+// space by the model-view-projection matrix and projected exactly once per
+// frame, the culler, the clipper and the wireframe then read the results by
+// index instead of transforming each face corner again. The transform runs in
+// single precision on position streams, a simd batch of vertexes per
+// operation, screen positions are kept in double for the rasterizer and in
+// float streams for the culling prepass.
+class vertex_cache
+{
+public:
+    // set in codes when the vertex is on or behind the camera plane
+    static const int behind = 1 << clip::planes_count;
+
+    void run(const model& m, int width, int height)
+    {
+        run(m, clip::fixed_camera(), width, height);
+    }
+
+    // Models with up to date normals already carry their positions as
+    // streams, others are converted here first.
+    void run(const model& m, const cmn::mat4& mvp, int width, int height)
+    {
+        if (m.normals_updated())
+        {
+            cmn::soa::transform(mvp, m.position_streams, _homogeneous);
+            project(m.faces_count(), width, height);
+            return;
+        }
+        const size_t vertex_count = m.vertexes.size();
+        _positions.resize(vertex_count);
+        for (size_t i = 0; i < vertex_count; ++i)
+        {
+            set_position(i, m.vertexes[i]);
+        }
+        cmn::soa::transform(mvp, _positions, _homogeneous);
+        project(m.faces_count(), width, height);
+    }
+
+    void run(const quantized_mesh& m, int width, int height)
+    {
+        run(m, clip::fixed_camera(), width, height);
+    }
+
+    // The dequantization is folded into the matrix and the 16 bit positions
+    // are converted batch by batch inside the transform, the full precision
+    // ones are never stored.
+    void run(const quantized_mesh& m, const cmn::mat4& mvp, int width, int height)
+    {
+        static_assert(sizeof(quantized_mesh::position_t) == 3*sizeof(uint16_t), "positions are read as packed x, y, z");
+        const cmn::vec3s origin(m.origin);
+        const cmn::vec3s step(m.step);
+        const cmn::mat4 decode_mvp = mvp*cmn::mat4::translation(origin)*cmn::mat4::scale(step);
+        cmn::soa::transform(decode_mvp, &m.positions.data()->x, m.vertexes_count(), _homogeneous);
+        project(m.faces_count(), width, height);
+    }
+
+    size_t size() const
+    {
+        return _clip.size();
+    }
+
+    const point4d& clip_coords(size_t idx) const
+    {
+        return _clip[idx];
+    }
+
+    // meaningless when the vertex is behind the camera
+    const point3d& screen_coords(size_t idx) const
+    {
+        return _screen[idx];
+    }
+
+    const float* x() const
+    {
+        return _xy.component(0);
+    }
+
+    const float* y() const
+    {
+        return _xy.component(1);
+    }
+
+    // viewport outcodes plus behind
+    const uint8_t* codes() const
+    {
+        return _codes.data();
+    }
+
+    const uint8_t* guard_codes() const
+    {
+        return _guard_codes.data();
+    }
+
+    const vertex_stats& stats() const
+    {
+        return _stats;
+    }
+
+private:
+    void set_position(size_t idx, const point3d& position)
+    {
+        _positions.set(0, idx, static_cast<float>(position.x()));
+        _positions.set(1, idx, static_cast<float>(position.y()));
+        _positions.set(2, idx, static_cast<float>(position.z()));
+    }
+
+    // clip::to_screen of the clip space positions in _homogeneous, one batch
+    // at a time in float.
+    void project(size_t face_count, int width, int height)
+    {
+        const size_t vertex_count = _homogeneous.size();
+        _clip.resize(vertex_count);
+        _screen.resize(vertex_count);
+        _xy.resize(vertex_count);
+        _codes.resize(vertex_count);
+        _guard_codes.resize(vertex_count);
+
+        const cmn::simd::float4 one = cmn::simd::splat(1.0f);
+        const cmn::simd::float4 half_width = cmn::simd::splat(width/2.0f);
+        const cmn::simd::float4 half_height = cmn::simd::splat(height/2.0f);
+        for (size_t b = 0; b < _homogeneous.batches(); ++b)
+        {
+            const cmn::simd::float4 w = _homogeneous.batch(3, b);
+            _xy.set_batch(0, b, cmn::simd::mul(cmn::simd::add(cmn::simd::div(_homogeneous.batch(0, b), w), one), half_width));
+            _xy.set_batch(1, b, cmn::simd::mul(cmn::simd::add(cmn::simd::div(_homogeneous.batch(1, b), w), one), half_height));
+            alignas(16) float z[cmn::simd::width];
+            cmn::simd::store(z, cmn::simd::div(_homogeneous.batch(2, b), w));
+
+            const size_t first = b*cmn::simd::width;
+            const size_t count = std::min(cmn::simd::width, vertex_count - first);
+            for (size_t j = 0; j < count; ++j)
+            {
+                const size_t i = first + j;
+                const point4d clip_coords({_homogeneous.get(0, i), _homogeneous.get(1, i), _homogeneous.get(2, i), _homogeneous.get(3, i)});
+                _clip[i] = clip_coords;
+                _screen[i] = point3d(_xy.get(0, i), _xy.get(1, i), z[j]);
+                _codes[i] = static_cast<uint8_t>(clip::outcode(clip_coords, 1.0) | (clip_coords[3] <= 0.0 ? behind : 0));
+                _guard_codes[i] = static_cast<uint8_t>(clip::outcode(clip_coords, clip::guard_band));
+            }
+        }
+        _stats.transformed = vertex_count;
+        _stats.corners = 3*face_count;
+    }
+
+    cmn::soa3 _positions;
+    cmn::soa4 _homogeneous;
+    cmn::soa_streams<2> _xy;
+    std::vector<point4d> _clip;
+    std::vector<point3d> _screen;
+    std::vector<uint8_t> _codes;
+    std::vector<uint8_t> _guard_codes;
+    vertex_stats _stats;
+};
+
+// clip_triangle for a face of the cached vertexes. Faces inside the guard band
+// are emitted from the cached screen positions, the rest are clipped from the
+// cached clip space positions.
+template<class emit_t>
+inline void clip_triangle(const vertex_cache& vertexes, size_t a, size_t b, size_t c, int width, int height, emit_t emit)
+{
+    const uint8_t* codes = vertexes.codes();
+    if ((codes[a] & codes[b] & codes[c]) & ~vertex_cache::behind)
+    {
+        return;
+    }
+    const uint8_t* guard_codes = vertexes.guard_codes();
+    if ((guard_codes[a] | guard_codes[b] | guard_codes[c]) == 0)
+    {
+        emit(triangle3d{{vertexes.screen_coords(a), vertexes.screen_coords(b), vertexes.screen_coords(c)}});
+        return;
+    }
+    clip_triangle(triangle4d{{vertexes.clip_coords(a), vertexes.clip_coords(b), vertexes.clip_coords(c)}}, width, height, emit);
+}
+
+} // end of namespace render
+
+#endif // VERTEX_CACHE_HPP
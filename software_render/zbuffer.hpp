@@ -1,15 +1,97 @@
 #ifndef ZBUFFER_HPP
 #define ZBUFFER_HPP
 
+#include <cstring>
 #include <memory>
 #include <limits>
 
+// Depth buffer, smaller values are closer. Rows are stored bottom up like the
+// render space, x + y*width.
 class z_buffer
 {
 public:
+    // memset of 0x7f bytes gives 3.39e+38f in every cell, so clearing is a
+    // single bulk fill instead of a per element loop.
+    static const int clear_byte = 0x7f;
+
+    z_buffer() :
+        _width(0)
+      , _height(0)
+    {}
+
+    z_buffer(int width, int height) :
+        _width(0)
+      , _height(0)
+    {
+        resize(width, height);
+    }
+
+    // Reallocates and clears only when the size changes.
+    void resize(int width, int height)
+    {
+        if (width == _width && height == _height)
+        {
+            return;
+        }
+        _buffer.reset(new float[static_cast<size_t>(width)*height]);
+        _width = width;
+        _height = height;
+        clear();
+    }
+
+    void clear()
+    {
+        std::memset(_buffer.get(), clear_byte, static_cast<size_t>(_width)*_height*sizeof(float));
+    }
+
+    static float far_value()
+    {
+        float value;
+        std::memset(&value, clear_byte, sizeof(value));
+        return value;
+    }
+
+    int width() const
+    {
+        return _width;
+    }
+
+    int height() const
+    {
+        return _height;
+    }
+
+    float* row(int y)
+    {
+        return _buffer.get() + static_cast<size_t>(y)*_width;
+    }
+
+    const float* row(int y) const
+    {
+        return _buffer.get() + static_cast<size_t>(y)*_width;
+    }
+
+    float& at(int x, int y)
+    {
+        return row(y)[x];
+    }
+
+    const float& at(int x, int y) const
+    {
+        return row(y)[x];
+    }
+
+    // Stores depth when it is closer than the current value.
+    bool test_and_set(int x, int y, float depth)
+    {
+        float& current = at(x, y);
+        const bool pass = depth < current;
+        current = pass ? depth : current;
+        return pass;
+    }
 
 private:
-    std::unique_ptr<int> _buffer;
+    std::unique_ptr<float[]> _buffer;
     int _width;
     int _height;
 };